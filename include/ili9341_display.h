@@ -2,20 +2,14 @@
 #define ILI9341_DISPLAY_H
 
 #include <Arduino.h>
-#include <SPI.h>
+#include "ili9341_transport.h"
+#include "ili9341_font.h"
 
 // ILI9341 Display Configuration
 #define ILI9341_WIDTH   320
 #define ILI9341_HEIGHT  240
 #define ILI9341_BPP     16  // 16-bit color (RGB565)
-
-// Teensy 4.x Pin Configuration
-#define TFT_CS    10    // Chip Select
-#define TFT_DC    9     // Data/Command
-#define TFT_RST   8     // Reset
-#define TFT_CLK   13    // SPI Clock (SCK)
-#define TFT_MOSI  11    // SPI Data In (MOSI)
-#define TFT_MISO  12    // SPI Data Out (MISO)
+#define ILI9341_GATE_LINES  320  // panel scan lines, along x in the landscape addressing used here
 
 // ILI9341 Commands
 #define ILI9341_SOFTRESET       0x01
@@ -32,6 +26,9 @@
 #define ILI9341_ROWADDRSET      0x2B
 #define ILI9341_MEMWRITE        0x2C
 #define ILI9341_MEMREAD         0x2E
+#define ILI9341_PARTIALAREA     0x30
+#define ILI9341_VSCRDEF         0x33
+#define ILI9341_VSCRSADD        0x37
 #define ILI9341_PIXELFORMAT     0x3A
 #define ILI9341_FRAMERATECTRL   0xB1
 #define ILI9341_DISPLAYFUNC     0xB6
@@ -54,37 +51,202 @@
 #define COLOR_GRAY      0x8410
 #define COLOR_ORANGE    0xFDA0
 
-// Display Buffer - using 16-bit RGB565 format
+// Blend 'fg' over 'bg' with coverage 0 - 255. The channels are spread
+// into one 32-bit word (green in the high half) so all three are scaled
+// by a single multiply.
+static inline uint16_t ili9341Blend(uint16_t fg, uint16_t bg, uint8_t alpha) {
+    uint32_t a = (alpha + 4) >> 3;   // 0 - 32
+    uint32_t f = (fg | ((uint32_t)fg << 16)) & 0x07E0F81F;
+    uint32_t b = (bg | ((uint32_t)bg << 16)) & 0x07E0F81F;
+    uint32_t r = ((((f - b) * a) >> 5) + b) & 0x07E0F81F;
+    return (uint16_t)(r | (r >> 16));
+}
+
+// Blend a run of 'src' pixels over 'dst' with per-pixel coverage; the same
+// result as ili9341Blend() on each pixel, several pixels at a time where
+// the host has SIMD
+void ili9341BlendRun(uint16_t *dst, const uint16_t *src, const uint8_t *alpha, uint32_t count);
+
+// Scale every channel of a run of pixels by keep / 32 (0 - 31), rounding
+// down, so repeated decay always reaches black
+void ili9341DecayRun(uint16_t *pixels, uint8_t keep, uint32_t count);
+
+// Framebuffer formats. Indexed modes store palette indices and expand them
+// to RGB565 a line at a time while flushing.
+typedef enum {
+    ILI9341_COLOR_RGB565,    // 16 bpp, 153.6 KB
+    ILI9341_COLOR_INDEXED8,  // 8 bpp, 256-entry palette, 76.8 KB
+    ILI9341_COLOR_INDEXED4   // 4 bpp, 16-entry palette, 38.4 KB
+} ILI9341ColorMode;
+
+// Render targets. Reduced modes rasterize into a smaller buffer and
+// duplicate pixels and lines while flushing, so the panel still gets a
+// full 320x240 image. Drawing coordinates stay in panel pixels.
+typedef enum {
+    ILI9341_RES_FULL,        // 320x240
+    ILI9341_RES_HALF,        // 160x120, a quarter of the memory and fill work
+    ILI9341_RES_HALF_WIDTH   // 160x240
+} ILI9341Resolution;
+
+// Bitmap for drawSprite(). 'mask' holds per-pixel coverage (0 = skip,
+// 255 = opaque, between = blended in RGB565 mode); nullptr means opaque.
 typedef struct {
-    uint16_t *framebuffer;
     uint16_t width;
     uint16_t height;
-    uint16_t *dirty_lines;  // Track which lines need updating
+    const uint16_t *pixels;   // RGB565, row-major, stride 'width'
+    const uint8_t *mask;
+} ILI9341Sprite;
+
+// One line for drawLines()
+typedef struct {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+    uint16_t color;
+} ILI9341Segment;
+
+// Bresenham state of a line in the drawLines() sweep, render pixels,
+// always stepping down (y0 <= y1)
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t x1;
+    int16_t y1;
+    int16_t dx;
+    int16_t dy;
+    int8_t sx;
+    int32_t err;
+    uint16_t pixel;
+    int16_t next;       // next line in the row bucket or the active list
+} ILI9341EdgeState;
+
+#define ILI9341_LINE_BATCH        64   // lines set up per drawLines() sweep
+
+#define ILI9341_PALETTE_SIZE      256
+#define ILI9341_PALETTE_CACHE     16   // RGB565 -> index lookups remembered
+#define ILI9341_TEXT_MAX_CHARS    ILI9341_GLYPH_CACHE  // characters drawn per drawString() call
+
+// Display Buffer - RGB565 or palette indices, depending on color_mode
+typedef struct {
+    uint16_t *framebuffer;  // RGB565 mode only
+    uint8_t *index_buffer;  // indexed modes only; 4 bpp packs the even pixel in the high nibble
+    uint16_t width;         // render target size, also the row stride
+    uint16_t height;
+    uint8_t shift_x;        // panel pixel = render pixel << shift
+    uint8_t shift_y;
+    uint32_t capacity;      // pixels allocated at initialize()
+    uint16_t *dirty_lines;  // Track which lines need updating (render rows)
+    uint16_t *dirty_x0;     // dirty column span of each row, render pixels
+    uint16_t *dirty_x1;
+    uint16_t *lit_x0;       // span of each row that may hold non-black pixels;
+    uint16_t *lit_x1;       // empty when lit_x0 > lit_x1 (RGB565 fading)
+    ILI9341ColorMode color_mode;
     bool is_initialized;
 } DisplayBuffer;
 
-// ILI9341 Driver Class
-class ILI9341Display {
+// ILI9341 Driver Class, parameterised on the bus transport (see
+// ili9341_transport.h). Use the ILI9341Display typedef unless a specific
+// transport is needed.
+template <class Transport>
+class ILI9341Driver {
 private:
+    Transport bus;
     DisplayBuffer buffer;
-    uint32_t spi_speed;
     
-    void writeCommand(uint8_t cmd);
-    void writeData(uint8_t data);
-    void writeData16(uint16_t data);
-    uint8_t readData(void);
+    // Partial display: only gate lines (columns) [partial_first,
+    // partial_last] are driven
+    bool partial_mode;
+    uint16_t partial_first;
+    uint16_t partial_last;
+    
+    // Hardware scroll area, in gate lines (columns); scroll_width 0 = none
+    uint16_t scroll_left;
+    uint16_t scroll_width;
+    uint16_t scroll_offset;   // first memory column shown, relative to scroll_left
+    
+    // Palette for indexed modes. Drawing colours are matched against
+    // palette_key; palette holds what is actually sent, so effects can
+    // change the output without changing which index a colour maps to.
+    uint16_t palette_key[ILI9341_PALETTE_SIZE];
+    uint16_t palette[ILI9341_PALETTE_SIZE];
+    uint16_t palette_used;
+    uint16_t palette_limit;   // 256 or 16
+    uint16_t cache_color[ILI9341_PALETTE_CACHE];
+    uint8_t cache_index[ILI9341_PALETTE_CACHE];
+    uint16_t cache_valid;     // one bit per cache slot
+    uint16_t line_buffer[ILI9341_WIDTH];
+    ILI9341Resolution resolution;
+    
+    // Rasterization clip, render pixels inclusive
+    int16_t clip_x0;
+    int16_t clip_y0;
+    int16_t clip_x1;
+    int16_t clip_y1;
+    
+    // Line batch: per-line state and the first line starting on each row
+    ILI9341EdgeState edge_table[ILI9341_LINE_BATCH];
+    int16_t edge_bucket[ILI9341_HEIGHT];
+    
+    // Text: the current font and its expanded cells, keyed by
+    // (font, character, fg, bg) so repeated strings never touch the bitmap
+    const ILI9341Font *font;
+    ILI9341Glyph glyph_cache[ILI9341_GLYPH_CACHE];
+    
+    // Rasterization into the framebuffer; 'pixel' is a native value
+    // (RGB565 or palette index) from toPixel()
+    uint16_t toPixel(uint16_t color);
+    void writePixel(int16_t x, int16_t y, uint16_t pixel);
+    void writeSpan(int16_t x0, int16_t x1, int16_t y, uint16_t pixel);
+    void storeSpan(int16_t x0, int16_t x1, int16_t y, uint16_t pixel);
+    void writeRun(int16_t x, int16_t y, const uint16_t *pixels, uint16_t count);
+    void markDirty(int16_t y, int16_t x0, int16_t x1);
+    void markAllDirty();
+    void flushColumns(uint16_t c0, uint16_t c1);
+    bool edgeRow(ILI9341EdgeState &e, int16_t &xa, int16_t &xb);
+    void blendPixel(int16_t x, int16_t y, uint16_t color, uint8_t alpha);
+    
+    // Text rows are assembled from cached cells; 'fg'/'bg' are the values
+    // to store in the cells (native pixels or RGB565)
+    const uint16_t* glyphCell(uint8_t c, uint16_t fg, uint16_t bg, uint64_t &claimed);
+    uint16_t gatherCells(uint16_t x, const char *str, uint16_t fg, uint16_t bg, uint8_t size, const uint16_t **cells);
+    void expandTextRow(const uint16_t **cells, uint16_t count, uint8_t cell_row, uint8_t size, uint16_t *out, uint16_t width);
+    
+    void writeCommand(uint8_t cmd) { bus.writeCommand(cmd); }
+    void writeData(uint8_t data) { bus.writeData(data); }
+    void writeData16(uint16_t data) { bus.writeData16(data); }
+    uint8_t readData(void) { return bus.readData(); }
     void setAddressWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
     
 public:
-    ILI9341Display();
-    ~ILI9341Display();
+    ILI9341Driver();
+    ~ILI9341Driver();
     
-    bool initialize();
+    bool initialize(ILI9341ColorMode mode = ILI9341_COLOR_RGB565,
+                    ILI9341Resolution resolution = ILI9341_RES_FULL);
     void reset();
     void displayOn();
     void displayOff();
     void setRotation(uint8_t rotation);
     
+    // The controller's partial and scroll areas are ranges of gate lines,
+    // which run along x in this landscape addressing, so both work on
+    // bands of columns.
+    
+    // Partial display mode: the panel only drives columns first - last and
+    // updateDisplay() only sends those columns
+    void enterPartialMode(uint16_t first, uint16_t last);
+    void exitPartialMode();
+    bool isPartialMode() const { return partial_mode; }
+    
+    // Hardware scrolling of a band of columns. scrollLine() writes one
+    // column into the band and moves the scroll start so it appears at the
+    // right; updateDisplay() leaves the band alone while it is defined.
+    void setScrollArea(uint16_t left, uint16_t width);
+    void clearScrollArea();
+    void setScrollStart(uint16_t offset);
+    void scrollLine(const uint16_t *pixels);
+    
     // Drawing functions
     void fillScreen(uint16_t color);
     void fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
@@ -94,14 +256,64 @@ public:
     void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
     void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
     
-    // Text functions
+    // Draw many lines in one top-to-bottom sweep; same pixels as drawLine()
+    void drawLines(const ILI9341Segment *segments, uint16_t count);
+    
+    // Anti-aliased line (Wu). Needs an RGB565 framebuffer to blend into;
+    // indexed modes get drawLine().
+    void drawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    
+    // Masked, clipped blit with the top-left corner at (x, y). Indexed
+    // framebuffers cannot blend, so coverage is thresholded at 128 there.
+    void drawSprite(int16_t x, int16_t y, const ILI9341Sprite &sprite);
+    
+    // Fade the framebuffer towards black inside the clip: each channel is
+    // scaled by keep / 256. Only rows and columns that can still hold
+    // colour are touched, so faded-out areas drop out of the next update.
+    // RGB565 only.
+    void fadeScreen(uint8_t keep);
+    
+    // Clip rectangle in panel pixels; drawing outside it is discarded.
+    // Reset to the whole screen by clearClipRect() and setResolution().
+    void setClipRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    void clearClipRect();
+    
+    // Text functions. Strings are written a row at a time from the glyph
+    // cache; without a framebuffer they go straight to the panel.
     void drawChar(uint16_t x, uint16_t y, char c, uint16_t color, uint16_t bg, uint8_t size = 1);
     void drawString(uint16_t x, uint16_t y, const char *str, uint16_t color, uint16_t bg, uint8_t size = 1);
+    void drawStringDirect(uint16_t x, uint16_t y, const char *str, uint16_t color, uint16_t bg, uint8_t size = 1);
+    bool setFont(const ILI9341Font *f);   // fails if the cell does not fit the cache
+    const ILI9341Font* getFont() const { return font; }
+    uint16_t getTextWidth(const char *str, uint8_t size = 1) const { return strlen(str) * font->advance * size; }
+    uint16_t getTextHeight(uint8_t size = 1) const { return font->line_height * size; }
     
     // Buffer functions
-    void updateDisplay();
+    void updateDisplay();       // sends the dirty span of dirty lines only
     void updateRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
     uint16_t* getFramebuffer();
+    uint8_t* getIndexBuffer() { return buffer.index_buffer; }
+    ILI9341ColorMode getColorMode() const { return buffer.color_mode; }
+    bool hasFramebuffer() const { return buffer.framebuffer || buffer.index_buffer; }
+    
+    // Switch render target; fails if it needs more pixels than were
+    // allocated at initialize(). The framebuffer content is undefined after
+    // a switch, so redraw before the next flush.
+    bool setResolution(ILI9341Resolution resolution);
+    ILI9341Resolution getResolution() const { return resolution; }
+    uint16_t getRenderWidth() const { return buffer.width; }
+    uint16_t getRenderHeight() const { return buffer.height; }
+    
+    // Palette (indexed modes). Colours passed to the drawing functions are
+    // assigned an index the first time they are seen; once the palette is
+    // full the nearest entry is used. Effects only touch the output side,
+    // so they cost O(palette) and need no redraw, just a flush.
+    void setPaletteEntry(uint8_t index, uint16_t color);
+    void remapPaletteEntry(uint8_t index, uint16_t color);
+    void fadePalette(uint8_t level);          // 255 = original colours, 0 = black
+    void resetPaletteEffects();
+    uint16_t getPaletteEntry(uint8_t index) const { return palette[index]; }
+    uint8_t colorIndex(uint16_t color);
     
     // Utility functions
     uint16_t rgb(uint8_t r, uint8_t g, uint8_t b);
@@ -111,6 +323,18 @@ public:
     // Get display dimensions
     uint16_t getWidth() const { return ILI9341_WIDTH; }
     uint16_t getHeight() const { return ILI9341_HEIGHT; }
+    
+    // Bus access, e.g. ILI9341HostSink statistics in host tests
+    Transport& getTransport() { return bus; }
 };
 
+// Instantiated in ili9341_display.cpp for every transport
+extern template class ILI9341Driver<ILI9341SpiTransport>;
+extern template class ILI9341Driver<ILI9341FastSpiTransport>;
+extern template class ILI9341Driver<ILI9341DmaSpiTransport>;
+extern template class ILI9341Driver<ILI9341Parallel8080Transport>;
+extern template class ILI9341Driver<ILI9341HostSink>;
+
+typedef ILI9341Driver<ILI9341_TRANSPORT> ILI9341Display;
+
 #endif // ILI9341_DISPLAY_H
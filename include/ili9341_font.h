@@ -0,0 +1,38 @@
+#ifndef ILI9341_FONT_H
+#define ILI9341_FONT_H
+
+#include <Arduino.h>
+
+// Glyph cache configuration
+#define ILI9341_GLYPH_CACHE       64   // expanded glyph cells kept in RAM (power of two, at most 64)
+#define ILI9341_GLYPH_MAX_PIXELS  64   // largest cell (advance x line height) that can be cached
+
+// Packed 1 bpp bitmap font. Each glyph is 'width' column bytes, bit 0 at
+// the top, stored back to back from 'first' to 'last'. A character cell is
+// 'advance' x 'line_height' pixels; the space right of and below the glyph
+// is background.
+typedef struct {
+    const uint8_t *data;
+    uint8_t first;
+    uint8_t last;
+    uint8_t width;
+    uint8_t height;
+    uint8_t advance;
+    uint8_t line_height;
+} ILI9341Font;
+
+// One character cell expanded to pixel values for a foreground/background
+// pair. The values are whatever the caller expanded with: RGB565 for the
+// panel, or palette indices for an indexed framebuffer.
+typedef struct {
+    const ILI9341Font *font;   // nullptr = empty slot
+    uint16_t fg;
+    uint16_t bg;
+    uint8_t c;
+    uint16_t pixels[ILI9341_GLYPH_MAX_PIXELS];
+} ILI9341Glyph;
+
+// Classic 5x7 ASCII font (0x20 - 0x7E) in a 6x8 cell
+extern const ILI9341Font ili9341_font5x7;
+
+#endif // ILI9341_FONT_H
@@ -0,0 +1,504 @@
+#ifndef ILI9341_TRANSPORT_H
+#define ILI9341_TRANSPORT_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#ifdef TEENSYDUINO
+#include <EventResponder.h>
+#endif
+
+// Teensy 4.x Pin Configuration
+#define TFT_CS    10    // Chip Select
+#ifndef TFT_DC
+#define TFT_DC    9     // Data/Command; -DTFT_DC=36 or 37 for hardware DC (see below)
+#endif
+#define TFT_RST   8     // Reset
+#define TFT_CLK   13    // SPI Clock (SCK)
+#define TFT_MOSI  11    // SPI Data In (MOSI)
+#define TFT_MISO  12    // SPI Data Out (MISO)
+
+// 8080 parallel bus: write/read strobes plus an 8-bit data lane. On
+// Teensy 4.x these data pins are bits 16-23 of GPIO6, so a byte is
+// written with one set and one clear of the port register.
+#define TFT_WR    36
+#define TFT_RD    37
+#define TFT_D0    19
+#define TFT_D1    18
+#define TFT_D2    14
+#define TFT_D3    15
+#define TFT_D4    40
+#define TFT_D5    41
+#define TFT_D6    17
+#define TFT_D7    16
+
+#define ILI9341_SPI_CLOCK   40000000  // 40 MHz
+#define ILI9341_DMA_CHUNK   320       // pixels per DMA bounce buffer
+
+// Set while a transport holds the bus, from the start of beginTransaction()
+// to the end of endTransaction(). Other devices on the same SPI bus check
+// it before selecting themselves, so an interrupt never lands in the
+// middle of a framebuffer transfer.
+extern volatile bool ili9341_bus_busy;
+
+// A device that finds the bus busy may ask for it instead of waiting for
+// its next turn. Framebuffer flushes check ili9341_bus_wanted between
+// rows; when it is set they release the bus, call ili9341_grantBus(),
+// which runs the callback, and carry on in a new transaction, so a long
+// flush holds another device off for at most one row. One request is
+// kept; a later one replaces it.
+typedef void (*ILI9341BusCallback)(void *context);
+extern volatile bool ili9341_bus_wanted;
+void ili9341_requestBus(ILI9341BusCallback callback, void *context);
+void ili9341_grantBus();
+
+// Bus transport policies for ILI9341Driver.
+//
+// A transport frames commands and data and moves runs of pixels. The
+// driver is a template over its transport, so every call below is
+// resolved at compile time and inlined into the drawing and flush loops.
+//
+//   void begin();                                      pins and bus setup
+//   void beginTransaction();                           select the panel
+//   void endTransaction();                             deselect once all writes are out
+//   void writeCommand(uint8_t cmd);
+//   void writeData(uint8_t data);
+//   void writeData16(uint16_t data);
+//   void writePixels(const uint16_t *pixels, uint32_t count);
+//   void fillPixels(uint16_t color, uint32_t count);
+//   uint8_t readData();
+
+// Blocking SPI through the Arduino SPI library
+class ILI9341SpiTransport {
+public:
+    void begin();
+    
+    void beginTransaction() {
+        ili9341_bus_busy = true;
+        SPI.beginTransaction(SPISettings(ILI9341_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+        digitalWrite(TFT_CS, LOW);
+    }
+    
+    void endTransaction() {
+        digitalWrite(TFT_CS, HIGH);
+        SPI.endTransaction();
+        ili9341_bus_busy = false;
+    }
+    
+    void writeCommand(uint8_t cmd) {
+        digitalWrite(TFT_DC, LOW);
+        SPI.transfer(cmd);
+    }
+    
+    void writeData(uint8_t data) {
+        digitalWrite(TFT_DC, HIGH);
+        SPI.transfer(data);
+    }
+    
+    void writeData16(uint16_t data) {
+        digitalWrite(TFT_DC, HIGH);
+        SPI.transfer16(data);
+    }
+    
+    void writePixels(const uint16_t *pixels, uint32_t count) {
+        digitalWrite(TFT_DC, HIGH);
+        while (count--) {
+            SPI.transfer16(*pixels++);
+        }
+    }
+    
+    void fillPixels(uint16_t color, uint32_t count) {
+        digitalWrite(TFT_DC, HIGH);
+        while (count--) {
+            SPI.transfer16(color);
+        }
+    }
+    
+    uint8_t readData() {
+        digitalWrite(TFT_DC, HIGH);
+        return SPI.transfer(0);
+    }
+};
+
+// SPI with CS and DC driven by direct port writes, and on Teensy 4.x
+// framed by the LPSPI peripheral itself.
+//
+// With constant pin numbers digitalWriteFast() compiles to a single store
+// to the port set/clear register. DC is only touched when it changes.
+//
+// On Teensy 4.x, if TFT_DC is on an LPSPI chip-select pin (10, 36 or 37
+// for SPI), DC becomes a hardware PCS line: each command/data switch is a
+// TCR write, which the LPSPI queues in the transmit FIFO together with the
+// data. Nothing waits between a command and its parameters; the CPU only
+// stalls when the FIFO is full or at the end of the transaction. With DC
+// on any other pin, including the default pin 9, the switch waits for the
+// FIFO to drain, then toggles the pin. CS already takes pin 10, so
+// hardware DC means wiring DC to 36 or 37 (Teensy 4.1) and building with
+// -DTFT_DC=<pin>; those pins are not free for the 8080 bus then.
+class ILI9341FastSpiTransport {
+private:
+#if defined(__IMXRT1062__)
+    uint32_t tcr_current;
+    uint32_t tcr_command;
+    uint32_t tcr_data;
+    uint32_t pcs_command;     // PCS selecting the DC line (DC low)
+    uint32_t pcs_data;        // PCS selecting an unused line (DC high)
+    bool hardware_dc;
+    bool dc_is_data;
+    
+    void waitFifoNotFull() {
+        while ((LPSPI4_FSR & 0x1F) >= 15) {
+        }
+    }
+    
+    void waitTransmitComplete() {
+        while (LPSPI4_FSR & 0x1F) {
+        }
+        while (LPSPI4_SR & LPSPI_SR_MBF) {
+        }
+    }
+    
+    // Queue a frame format change; TCR writes go through the TX FIFO
+    void setTCR(uint32_t tcr) {
+        if (tcr != tcr_current) {
+            waitFifoNotFull();
+            tcr_current = tcr;
+            LPSPI4_TCR = tcr;
+        }
+    }
+    
+    void frame(bool data, uint32_t bits) {
+        if (hardware_dc) {
+            setTCR((data ? tcr_data : tcr_command) | LPSPI_TCR_FRAMESZ(bits - 1) | LPSPI_TCR_CONT | LPSPI_TCR_RXMSK);
+            return;
+        }
+        if (data != dc_is_data) {
+            waitTransmitComplete();
+            digitalWriteFast(TFT_DC, data ? HIGH : LOW);
+            dc_is_data = data;
+        }
+        setTCR(tcr_data | LPSPI_TCR_FRAMESZ(bits - 1) | LPSPI_TCR_CONT | LPSPI_TCR_RXMSK);
+    }
+    
+    void push(uint32_t word) {
+        waitFifoNotFull();
+        LPSPI4_TDR = word;
+    }
+#else
+    bool dc_is_data;
+    
+    void setDC(bool data) {
+        if (data != dc_is_data) {
+            digitalWriteFast(TFT_DC, data ? HIGH : LOW);
+            dc_is_data = data;
+        }
+    }
+#endif
+
+public:
+    void begin();
+    
+#if defined(__IMXRT1062__)
+    void beginTransaction() {
+        ili9341_bus_busy = true;
+        SPI.beginTransaction(SPISettings(ILI9341_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+        tcr_current = LPSPI4_TCR;
+        uint32_t base = tcr_current & ~(LPSPI_TCR_FRAMESZ(31) | LPSPI_TCR_PCS(3));
+        tcr_command = base | pcs_command;
+        tcr_data = base | pcs_data;
+        digitalWriteFast(TFT_CS, LOW);
+    }
+    
+    void endTransaction() {
+        // Dropping CONT ends the continuous frame once the FIFO drains
+        setTCR(tcr_current & ~LPSPI_TCR_CONT);
+        waitTransmitComplete();
+        digitalWriteFast(TFT_CS, HIGH);
+        SPI.endTransaction();
+        ili9341_bus_busy = false;
+    }
+    
+    void writeCommand(uint8_t cmd) {
+        frame(false, 8);
+        push(cmd);
+    }
+    
+    void writeData(uint8_t data) {
+        frame(true, 8);
+        push(data);
+    }
+    
+    void writeData16(uint16_t data) {
+        frame(true, 16);
+        push(data);
+    }
+    
+    void writePixels(const uint16_t *pixels, uint32_t count) {
+        frame(true, 16);
+        while (count--) {
+            push(*pixels++);
+        }
+    }
+    
+    void fillPixels(uint16_t color, uint32_t count) {
+        frame(true, 16);
+        while (count--) {
+            push(color);
+        }
+    }
+    
+    // Receive is masked on the queued path; not used by the driver
+    uint8_t readData() { return 0; }
+#else
+    void beginTransaction() {
+        ili9341_bus_busy = true;
+        SPI.beginTransaction(SPISettings(ILI9341_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+        digitalWriteFast(TFT_CS, LOW);
+    }
+    
+    void endTransaction() {
+        digitalWriteFast(TFT_CS, HIGH);
+        SPI.endTransaction();
+        ili9341_bus_busy = false;
+    }
+    
+    void writeCommand(uint8_t cmd) {
+        setDC(false);
+        SPI.transfer(cmd);
+    }
+    
+    void writeData(uint8_t data) {
+        setDC(true);
+        SPI.transfer(data);
+    }
+    
+    void writeData16(uint16_t data) {
+        setDC(true);
+        SPI.transfer16(data);
+    }
+    
+    void writePixels(const uint16_t *pixels, uint32_t count) {
+        setDC(true);
+        while (count--) {
+            SPI.transfer16(*pixels++);
+        }
+    }
+    
+    void fillPixels(uint16_t color, uint32_t count) {
+        setDC(true);
+        while (count--) {
+            SPI.transfer16(color);
+        }
+    }
+    
+    uint8_t readData() {
+        setDC(true);
+        return SPI.transfer(0);
+    }
+#endif
+};
+
+// SPI with pixel runs sent by DMA. Runs are byte-swapped into one of two
+// bounce buffers, so the next chunk is prepared while the previous one is
+// on the wire. Command and parameter writes wait for the DMA to finish.
+// Without TEENSYDUINO this behaves like ILI9341SpiTransport.
+class ILI9341DmaSpiTransport : public ILI9341SpiTransport {
+private:
+    uint8_t bounce[2][ILI9341_DMA_CHUNK * 2];
+    uint8_t next_bounce;
+    volatile bool busy;
+#ifdef TEENSYDUINO
+    EventResponder done;
+    static void onDone(EventResponderRef event);
+#endif
+
+    void startChunk(const uint8_t *bytes, uint32_t count);
+    
+public:
+    ILI9341DmaSpiTransport() : next_bounce(0), busy(false) {}
+    
+    void begin();
+    
+    void waitIdle() {
+        while (busy) {
+        }
+    }
+    
+    void endTransaction() {
+        waitIdle();
+        ILI9341SpiTransport::endTransaction();
+    }
+    
+    void writeCommand(uint8_t cmd) {
+        waitIdle();
+        ILI9341SpiTransport::writeCommand(cmd);
+    }
+    
+    void writeData(uint8_t data) {
+        waitIdle();
+        ILI9341SpiTransport::writeData(data);
+    }
+    
+    void writeData16(uint16_t data) {
+        waitIdle();
+        ILI9341SpiTransport::writeData16(data);
+    }
+    
+    void writePixels(const uint16_t *pixels, uint32_t count);
+    void fillPixels(uint16_t color, uint32_t count);
+    
+    uint8_t readData() {
+        waitIdle();
+        return ILI9341SpiTransport::readData();
+    }
+};
+
+// 8-bit 8080-style parallel bus. DC selects command/data and each byte is
+// latched on the rising edge of WR. Teensy 4.x writes the byte lane through
+// the GPIO6 port register; other boards fall back to one pin at a time.
+class ILI9341Parallel8080Transport {
+private:
+    void writeByte(uint8_t b) {
+#if defined(__IMXRT1062__)
+        GPIO6_DR_CLEAR = 0xFFu << 16;
+        GPIO6_DR_SET = (uint32_t)b << 16;
+#else
+        static const uint8_t lane[8] = { TFT_D0, TFT_D1, TFT_D2, TFT_D3, TFT_D4, TFT_D5, TFT_D6, TFT_D7 };
+        for (int i = 0; i < 8; i++) {
+            digitalWriteFast(lane[i], (b >> i) & 1);
+        }
+#endif
+        digitalWriteFast(TFT_WR, LOW);
+        digitalWriteFast(TFT_WR, HIGH);
+    }
+    
+public:
+    void begin();
+    
+    void beginTransaction() { digitalWriteFast(TFT_CS, LOW); }
+    void endTransaction() { digitalWriteFast(TFT_CS, HIGH); }
+    
+    void writeCommand(uint8_t cmd) {
+        digitalWriteFast(TFT_DC, LOW);
+        writeByte(cmd);
+    }
+    
+    void writeData(uint8_t data) {
+        digitalWriteFast(TFT_DC, HIGH);
+        writeByte(data);
+    }
+    
+    void writeData16(uint16_t data) {
+        digitalWriteFast(TFT_DC, HIGH);
+        writeByte(data >> 8);
+        writeByte(data & 0xFF);
+    }
+    
+    void writePixels(const uint16_t *pixels, uint32_t count) {
+        digitalWriteFast(TFT_DC, HIGH);
+        while (count--) {
+            uint16_t p = *pixels++;
+            writeByte(p >> 8);
+            writeByte(p & 0xFF);
+        }
+    }
+    
+    void fillPixels(uint16_t color, uint32_t count) {
+        digitalWriteFast(TFT_DC, HIGH);
+        while (count--) {
+            writeByte(color >> 8);
+            writeByte(color & 0xFF);
+        }
+    }
+    
+    // Reads need the lane turned around; not used by the driver
+    uint8_t readData() { return 0; }
+};
+
+// Panel memory emulated by ILI9341HostSink, in the driver's coordinates
+#define ILI9341_SINK_COLUMNS  320
+#define ILI9341_SINK_ROWS     320
+
+// Called by ILI9341HostSink in the middle of a transfer
+typedef void (*ILI9341SinkHook)(void *context);
+
+// In-memory sink for host builds and tests. Decodes address-window,
+// memory-write, scroll and partial-area commands into a panel image and
+// counts traffic, so flush logic can be checked without hardware.
+// Scroll and partial areas are in gate lines, which are panel columns in
+// the driver's landscape addressing.
+class ILI9341HostSink {
+private:
+    uint8_t command;
+    uint8_t params[6];
+    uint8_t param_count;
+    uint16_t col_start, col_end, row_start, row_end;
+    uint16_t cursor_x, cursor_y;
+    
+    void feedByte(uint8_t b);
+    void storePixel(uint16_t pixel);
+    
+public:
+    uint16_t *panel;             // ILI9341_SINK_COLUMNS x ILI9341_SINK_ROWS
+    uint32_t transactions;
+    uint32_t commands;
+    uint32_t data_bytes;
+    uint32_t pixels;
+    uint16_t scroll_start;       // last VSCRSADD value
+    uint16_t scroll_fixed_left;  // last VSCRDEF: fixed, scrolling and fixed gate lines
+    uint16_t scroll_lines;
+    uint16_t scroll_fixed_right;
+    uint16_t partial_first;      // last PTLAR
+    uint16_t partial_last;
+    bool in_transaction;
+    
+    // Optional: called every 'hook_pixels' pixels while a transaction is
+    // open, to run interrupt-like code while the panel holds the bus
+    ILI9341SinkHook pixel_hook;
+    void *hook_context;
+    uint32_t hook_pixels;
+    
+    ILI9341HostSink();
+    ~ILI9341HostSink();
+    
+    void begin();
+    void resetCounters() { transactions = commands = data_bytes = pixels = 0; }
+    uint16_t pixelAt(uint16_t x, uint16_t y) const { return panel ? panel[y * ILI9341_SINK_COLUMNS + x] : 0; }
+    
+    // Pixel the glass shows at (x, y), after the hardware scroll
+    uint16_t shownAt(uint16_t x, uint16_t y) const;
+    
+    void beginTransaction() { transactions++; in_transaction = true; ili9341_bus_busy = true; }
+    void endTransaction() { in_transaction = false; ili9341_bus_busy = false; }
+    void writeCommand(uint8_t cmd);
+    void writeData(uint8_t data) { data_bytes++; feedByte(data); }
+    void writeData16(uint16_t data) { writeData(data >> 8); writeData(data & 0xFF); }
+    
+    void writePixels(const uint16_t *src, uint32_t count) {
+        data_bytes += count * 2;
+        while (count--) {
+            storePixel(*src++);
+        }
+    }
+    
+    void fillPixels(uint16_t color, uint32_t count) {
+        data_bytes += count * 2;
+        while (count--) {
+            storePixel(color);
+        }
+    }
+    
+    uint8_t readData() { return 0; }
+};
+
+// Transport used by the ILI9341Display typedef; override with
+// -DILI9341_TRANSPORT=<class> in build_flags
+#ifndef ILI9341_TRANSPORT
+#ifdef ARDUINO
+#define ILI9341_TRANSPORT ILI9341SpiTransport
+#else
+#define ILI9341_TRANSPORT ILI9341HostSink
+#endif
+#endif
+
+#endif // ILI9341_TRANSPORT_H
@@ -0,0 +1,95 @@
+#ifndef PAZERVILLE_AUDIO_H
+#define PAZERVILLE_AUDIO_H
+
+#include <Arduino.h>
+#include "pazerville_mailbox.h"
+
+// Audio analysis configuration
+#define PAZERVILLE_AUDIO_BLOCK_SIZE   256   // samples per FFT block (power of two)
+#define PAZERVILLE_AUDIO_LOG2_BLOCK   8
+#define PAZERVILLE_AUDIO_BANDS        8
+#define PAZERVILLE_AUDIO_SAMPLE_RATE  22050
+#define PAZERVILLE_AUDIO_MIN_FREQ     60.0f
+
+// Analysis results for one audio block
+typedef struct {
+    float band[PAZERVILLE_AUDIO_BANDS];    // smoothed band magnitude, 0.0 - 1.0
+    float peak[PAZERVILLE_AUDIO_BANDS];    // peak follower per band, 0.0 - 1.0
+    float rms;                             // time-domain RMS level of the block, 0.0 - 1.0
+    uint32_t block_index;                  // increments once per analysed block
+} PazervilleAudioFrame;
+
+// Windowed fixed-point FFT analyser.
+//
+// Samples are pushed one at a time from the sampling interrupt, which
+// only stores them: capture is double-buffered, and each full block of
+// PAZERVILLE_AUDIO_BLOCK_SIZE samples is handed over while the next one
+// fills. read() runs the analysis on the frame loop and publishes the
+// result through a PazervilleMailbox, so processBlock() may also be
+// driven from a low-priority interrupt. Neither side ever waits; a block
+// that completes before the previous one was read is dropped.
+class PazervilleAudio {
+private:
+    // Capture: the ISR fills capture[capture_block] while read() may be
+    // analysing capture[ready_block]
+    int16_t capture[2][PAZERVILLE_AUDIO_BLOCK_SIZE];
+    uint8_t capture_block;
+    uint16_t capture_pos;
+    uint8_t ready_block;
+    volatile bool capture_ready;    // ready_block holds a block not yet analysed
+    volatile uint32_t dropped_blocks;
+    
+    // FFT working set and tables (Q15)
+    int16_t fft_re[PAZERVILLE_AUDIO_BLOCK_SIZE];
+    int16_t fft_im[PAZERVILLE_AUDIO_BLOCK_SIZE];
+    int16_t window[PAZERVILLE_AUDIO_BLOCK_SIZE];
+    int16_t twiddle_cos[PAZERVILLE_AUDIO_BLOCK_SIZE / 2];
+    int16_t twiddle_sin[PAZERVILLE_AUDIO_BLOCK_SIZE / 2];
+    uint16_t band_start[PAZERVILLE_AUDIO_BANDS + 1];  // first FFT bin of each band
+    
+    // Follower state, owned by processBlock()
+    float smooth_band[PAZERVILLE_AUDIO_BANDS];
+    float peak_band[PAZERVILLE_AUDIO_BANDS];
+    float smoothing;
+    float peak_release;
+    uint32_t block_count;
+    uint32_t sample_rate;
+    
+    PazervilleMailbox<PazervilleAudioFrame> frames;
+    
+    uint8_t input_pin;
+    
+    void computeTables();
+    void computeBands();
+    void runFFT();
+    
+public:
+    PazervilleAudio();
+    
+    // Start background sampling of an analog pin (Teensy only)
+    bool begin(uint8_t pin, uint32_t rate = PAZERVILLE_AUDIO_SAMPLE_RATE);
+    void end();
+    
+    // Set the rate of externally pushed samples and rebuild the band map
+    void setSampleRate(uint32_t rate);
+    
+    // Producer side: call from the sampling ISR, or from a file reader on the host
+    void pushSample(int16_t sample);
+    
+    // Analyse one block and publish it; read() calls this for captured blocks
+    void processBlock(const int16_t *samples);
+    
+    // Consumer side: analyses a waiting block, then copies the newest
+    // frame; returns false if nothing new
+    bool read(PazervilleAudioFrame *frame);
+    
+    // Follower tuning (0.0 - 1.0 per block)
+    void setSmoothing(float s) { smoothing = s; }
+    void setPeakRelease(float r) { peak_release = r; }
+    
+    uint32_t getSampleRate() const { return sample_rate; }
+    uint32_t getDroppedBlocks() const { return dropped_blocks; }
+    uint16_t getBandStartBin(int band) const { return band_start[band]; }
+};
+
+#endif // PAZERVILLE_AUDIO_H
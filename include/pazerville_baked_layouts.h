@@ -0,0 +1,112 @@
+// Generated by tools/bake_layout.cpp - do not edit
+// damping=0.950 gravity=0.000 time_step=0.0100
+
+#ifndef PAZERVILLE_BAKED_LAYOUTS_H
+#define PAZERVILLE_BAKED_LAYOUTS_H
+
+#include "pazerville_display.h"
+
+// star:5: settled after 500 steps
+constexpr PazervilleLayoutNode pazerville_layout_star_5_nodes[] PROGMEM = {
+    { 220.000f, 120.000f, 1.000f, 0xF800, 4 },
+    { 178.540f, 177.061f, 1.000f, 0x07E0, 4 },
+    { 111.462f, 155.265f, 1.000f, 0x001F, 4 },
+    { 111.462f, 84.735f, 1.000f, 0x07FF, 4 },
+    { 178.540f, 62.939f, 1.000f, 0xF81F, 4 },
+    { 160.000f, 120.000f, 2.000f, 0xFFE0, 5 },
+};
+constexpr PazervilleLayoutEdge pazerville_layout_star_5_edges[] PROGMEM = {
+    { 0, 5, 0.200f, 60.000f, 0x8410 },
+    { 1, 5, 0.200f, 60.000f, 0x8410 },
+    { 2, 5, 0.200f, 60.000f, 0x8410 },
+    { 3, 5, 0.200f, 60.000f, 0x8410 },
+    { 4, 5, 0.200f, 60.000f, 0x8410 },
+};
+constexpr PazervilleLayout pazerville_layout_star_5 = {
+    pazerville_layout_star_5_nodes, 6,
+    pazerville_layout_star_5_edges, 5
+};
+
+// ring:6: settled after 9175 steps
+constexpr PazervilleLayoutNode pazerville_layout_ring_6_nodes[] PROGMEM = {
+    { 229.820f, 120.000f, 1.000f, 0xF800, 4 },
+    { 194.909f, 180.462f, 1.000f, 0x07E0, 4 },
+    { 125.091f, 180.462f, 1.000f, 0x001F, 4 },
+    { 90.179f, 120.000f, 1.000f, 0x07FF, 4 },
+    { 125.091f, 59.538f, 1.000f, 0xF81F, 4 },
+    { 194.909f, 59.538f, 1.000f, 0xFFE0, 4 },
+};
+constexpr PazervilleLayoutEdge pazerville_layout_ring_6_edges[] PROGMEM = {
+    { 0, 1, 0.250f, 70.000f, 0x8410 },
+    { 1, 2, 0.250f, 70.000f, 0x8410 },
+    { 2, 3, 0.250f, 70.000f, 0x8410 },
+    { 3, 4, 0.250f, 70.000f, 0x8410 },
+    { 4, 5, 0.250f, 70.000f, 0x8410 },
+    { 5, 0, 0.250f, 70.000f, 0x8410 },
+};
+constexpr PazervilleLayout pazerville_layout_ring_6 = {
+    pazerville_layout_ring_6_nodes, 6,
+    pazerville_layout_ring_6_edges, 6
+};
+
+// chain:5: settled after 12627 steps
+constexpr PazervilleLayoutNode pazerville_layout_chain_5_nodes[] PROGMEM = {
+    { 58.540f, 120.000f, 1.000f, 0xF800, 4 },
+    { 108.716f, 120.000f, 1.000f, 0x07E0, 4 },
+    { 159.000f, 120.000f, 1.000f, 0x001F, 4 },
+    { 209.287f, 120.000f, 1.000f, 0x07FF, 4 },
+    { 259.466f, 120.000f, 1.000f, 0xF81F, 4 },
+};
+constexpr PazervilleLayoutEdge pazerville_layout_chain_5_edges[] PROGMEM = {
+    { 0, 1, 0.300f, 50.000f, 0x8410 },
+    { 1, 2, 0.300f, 50.000f, 0x8410 },
+    { 2, 3, 0.300f, 50.000f, 0x8410 },
+    { 3, 4, 0.300f, 50.000f, 0x8410 },
+};
+constexpr PazervilleLayout pazerville_layout_chain_5 = {
+    pazerville_layout_chain_5_nodes, 5,
+    pazerville_layout_chain_5_edges, 4
+};
+
+// grid:2x2: settled after 500 steps
+constexpr PazervilleLayoutNode pazerville_layout_grid_2x2_nodes[] PROGMEM = {
+    { 106.000f, 80.000f, 1.000f, 0xF800, 3 },
+    { 212.000f, 80.000f, 1.000f, 0x07E0, 3 },
+    { 106.000f, 160.000f, 1.000f, 0x07E0, 3 },
+    { 212.000f, 160.000f, 1.000f, 0x001F, 3 },
+};
+constexpr PazervilleLayoutEdge pazerville_layout_grid_2x2_edges[] PROGMEM = {
+    { 0, 1, 0.200f, 106.000f, 0x8410 },
+    { 0, 2, 0.200f, 80.000f, 0x8410 },
+    { 1, 3, 0.200f, 80.000f, 0x8410 },
+    { 2, 3, 0.200f, 106.000f, 0x8410 },
+};
+constexpr PazervilleLayout pazerville_layout_grid_2x2 = {
+    pazerville_layout_grid_2x2_nodes, 4,
+    pazerville_layout_grid_2x2_edges, 4
+};
+
+// tree: settled after 25026 steps
+constexpr PazervilleLayoutNode pazerville_layout_tree_nodes[] PROGMEM = {
+    { 160.000f, 66.777f, 1.500f, 0xF800, 4 },
+    { 110.877f, 78.642f, 1.200f, 0xFDA0, 4 },
+    { 209.125f, 78.639f, 1.200f, 0xFDA0, 4 },
+    { 68.618f, 105.952f, 1.000f, 0xFFE0, 4 },
+    { 117.740f, 128.109f, 1.000f, 0xFFE0, 4 },
+    { 202.289f, 128.110f, 1.000f, 0xFFE0, 4 },
+    { 251.383f, 105.952f, 1.000f, 0xFFE0, 4 },
+};
+constexpr PazervilleLayoutEdge pazerville_layout_tree_edges[] PROGMEM = {
+    { 0, 1, 0.200f, 50.000f, 0x8410 },
+    { 0, 2, 0.200f, 50.000f, 0x8410 },
+    { 1, 3, 0.200f, 50.000f, 0x8410 },
+    { 1, 4, 0.200f, 50.000f, 0x8410 },
+    { 2, 5, 0.200f, 50.000f, 0x8410 },
+    { 2, 6, 0.200f, 50.000f, 0x8410 },
+};
+constexpr PazervilleLayout pazerville_layout_tree = {
+    pazerville_layout_tree_nodes, 7,
+    pazerville_layout_tree_edges, 6
+};
+
+#endif // PAZERVILLE_BAKED_LAYOUTS_H
@@ -0,0 +1,81 @@
+#ifndef PAZERVILLE_COMMANDS_H
+#define PAZERVILLE_COMMANDS_H
+
+#include "ili9341_display.h"
+
+// Command queue configuration
+#define PAZERVILLE_COMMAND_SLOTS  32  // ring size (power of two)
+
+// Stable reference to a node or edge slot. A handle stops being valid
+// when its element is removed, even if the slot is later reused.
+typedef struct {
+    int16_t index;        // slot index, -1 if allocation failed
+    uint16_t generation;
+} PazervilleHandle;
+
+// Deferred changes to a PazervilleDisplay, applied in posting order at
+// the start of the next update() or simulate() call
+typedef enum {
+    PAZERVILLE_CMD_SET_DAMPING,    // value
+    PAZERVILLE_CMD_SET_GRAVITY,    // value
+    PAZERVILLE_CMD_SET_TIME_STEP,  // value
+    PAZERVILLE_CMD_SET_FIELD,      // field: strength and position of a force field
+    PAZERVILLE_CMD_IMPULSE,        // force: one-step push, as applyImpulse()
+    PAZERVILLE_CMD_REPEL,          // force: velocity kick, as repelNode()
+    PAZERVILLE_CMD_ADD_NODE,       // add_node
+    PAZERVILLE_CMD_ADD_EDGE,       // add_edge
+    PAZERVILLE_CMD_REMOVE_NODE,    // target
+    PAZERVILLE_CMD_REMOVE_EDGE     // target
+} PazervilleCommandType;
+
+typedef struct {
+    PazervilleCommandType type;
+    union {
+        float value;
+        struct { int16_t index; float strength, x, y; } field;
+        struct { PazervilleHandle node; float fx, fy; } force;
+        struct { float x, y, mass; uint16_t color; uint8_t radius; } add_node;
+        struct { PazervilleHandle node1, node2; float spring_constant, rest_length; } add_edge;
+        PazervilleHandle target;
+    };
+} PazervilleCommand;
+
+// Bounded multi-producer, single-consumer ring of commands.
+//
+// Any context may post, including interrupts that preempt each other or
+// the frame loop: a producer claims a slot with one compare-and-swap on
+// the tail, fills it, then publishes it through the slot's sequence
+// number. Nothing waits and interrupts stay enabled. When the ring is
+// full the command is dropped and counted. Only the owning
+// PazervilleDisplay pops, from update() and simulate().
+class PazervilleCommandQueue {
+private:
+    typedef struct {
+        volatile uint32_t sequence;  // == position when free, position + 1 when filled
+        PazervilleCommand command;
+    } Slot;
+    
+    Slot slots[PAZERVILLE_COMMAND_SLOTS];
+    volatile uint32_t tail;          // next position to claim, shared by producers
+    uint32_t head;                   // next position to pop, consumer only
+    volatile uint32_t dropped;
+    
+public:
+    PazervilleCommandQueue();
+    
+    // Producer side, safe from any context; false if the ring is full
+    bool post(const PazervilleCommand &command);
+    bool postValue(PazervilleCommandType type, float value);
+    bool postField(int field, float strength, float x, float y);
+    bool postForce(PazervilleCommandType type, PazervilleHandle node, float fx, float fy);
+    bool postAddNode(float x, float y, float mass, uint16_t color = COLOR_WHITE, uint8_t radius = 3);
+    bool postAddEdge(PazervilleHandle node1, PazervilleHandle node2, float spring_constant = 0.01f, float rest_length = 50.0f);
+    bool postRemove(PazervilleCommandType type, PazervilleHandle target);
+    
+    // Consumer side: the oldest published command, false if none is ready
+    bool pop(PazervilleCommand *command);
+    
+    uint32_t getDropped() const { return dropped; }
+};
+
+#endif // PAZERVILLE_COMMANDS_H
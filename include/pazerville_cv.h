@@ -0,0 +1,81 @@
+#ifndef PAZERVILLE_CV_H
+#define PAZERVILLE_CV_H
+
+#include <Arduino.h>
+
+// CV input configuration
+#define PAZERVILLE_CV_MAX_CHANNELS  4
+#define PAZERVILLE_CV_RING_SIZE     16    // raw history per channel (power of two)
+#define PAZERVILLE_CV_MEDIAN_TAPS   5
+#define PAZERVILLE_CV_SAMPLE_RATE   1000  // per channel, Hz
+#define PAZERVILLE_CV_FULL_SCALE    4095  // 12-bit conversions
+
+// Response curves applied after filtering, input and output 0.0 - 1.0
+typedef enum {
+    PAZERVILLE_CURVE_LINEAR,
+    PAZERVILLE_CURVE_EXPONENTIAL,  // x^2, fine control at the low end
+    PAZERVILLE_CURVE_LOGARITHMIC,  // sqrt(x), fine control at the high end
+    PAZERVILLE_CURVE_SCURVE        // smoothstep, fine control at both ends
+} PazervilleCurve;
+
+// Scripted signal source for hosts without an ADC: returns a raw
+// 0 - PAZERVILLE_CV_FULL_SCALE reading for a channel at a given time
+typedef uint16_t (*PazervilleCVSource)(uint8_t channel, uint32_t time_us);
+
+// Pazerville CV channel structure
+typedef struct {
+    uint8_t pin;
+    bool median;                 // median of the last PAZERVILLE_CV_MEDIAN_TAPS samples
+    float smoothing;             // one-pole coefficient, 1.0 = unfiltered
+    PazervilleCurve curve;
+    float out_min;
+    float out_max;
+    
+    // Written by the sampling ISR only
+    uint16_t ring[PAZERVILLE_CV_RING_SIZE];
+    volatile uint32_t head;      // total samples taken
+    volatile float filtered;     // 0.0 - 1.0, read without locking
+    bool active;
+} PazervilleCVChannel;
+
+// Background-sampled, filtered control-voltage inputs.
+//
+// A timer interrupt converts every configured channel, pushes the raw
+// reading into that channel's ring, and updates the filtered value. The
+// frame loop only reads the already-filtered value, so it never waits on
+// a conversion.
+class PazervilleCV {
+private:
+    PazervilleCVChannel channels[PAZERVILLE_CV_MAX_CHANNELS];
+    int channel_count;
+    PazervilleCVSource source;
+    uint32_t sample_rate;
+    
+    uint16_t medianOf(const PazervilleCVChannel &ch);
+    float applyCurve(PazervilleCurve curve, float x);
+    
+public:
+    PazervilleCV();
+    
+    // Add an input; returns the channel index or -1 if full
+    int addChannel(uint8_t pin, float out_min = 0.0f, float out_max = 1.0f,
+                   PazervilleCurve curve = PAZERVILLE_CURVE_LINEAR);
+    PazervilleCVChannel* getChannel(int idx) { return (idx >= 0 && idx < channel_count) ? &channels[idx] : nullptr; }
+    
+    // Start/stop background sampling (Teensy only)
+    bool begin(uint32_t rate = PAZERVILLE_CV_SAMPLE_RATE);
+    void end();
+    
+    // Replace analogRead with a scripted source (host replay)
+    void setSource(PazervilleCVSource src) { source = src; }
+    
+    // Sample every channel once; called from the timer ISR, or by hand on the host
+    void sampleTick();
+    
+    // Zero-wait reads from the frame loop
+    float read(int idx);         // filtered, curved and mapped to [out_min, out_max]
+    float readNormalized(int idx);
+    uint16_t readRaw(int idx);   // newest unfiltered conversion
+};
+
+#endif // PAZERVILLE_CV_H
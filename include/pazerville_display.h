@@ -2,6 +2,11 @@
 #define PAZERVILLE_DISPLAY_H
 
 #include "ili9341_display.h"
+#include "pazerville_math.h"
+#include "pazerville_hud.h"
+#include "pazerville_sprites.h"
+#include "pazerville_touch.h"
+#include "pazerville_commands.h"
 #include <math.h>
 
 // Pazerville module configuration for ILI9341
@@ -9,6 +14,46 @@
 #define PAZERVILLE_HEIGHT 240
 #define PAZERVILLE_MAX_NODES 8
 #define PAZERVILLE_MAX_EDGES 32
+#define PAZERVILLE_MAX_FIELDS 8
+
+// Active-set scheduling defaults (see setActiveSet())
+#define PAZERVILLE_SETTLE_SPEED  0.1f  // nodes slower than this are settling
+#define PAZERVILLE_SETTLE_STEPS  30    // steps below the speed before sleeping
+#define PAZERVILLE_SETTLE_HOPS   1     // neighbourhood kept awake around moving nodes
+
+// Graph size at which setAutoResolution() drops to half-resolution
+// rendering: three quarters of capacity, so it switches before the graph
+// is full and follows the limits above
+#define PAZERVILLE_HALF_RES_NODES  (PAZERVILLE_MAX_NODES * 3 / 4)
+#define PAZERVILLE_HALF_RES_EDGES  (PAZERVILLE_MAX_EDGES * 3 / 4)
+
+// Node collisions (see setCollisions()): share of the closing speed kept
+// after a bounce
+#define PAZERVILLE_COLLISION_RESTITUTION  0.5f
+
+// Constraint solver iterations per step (see setSolver())
+#define PAZERVILLE_SOLVER_ITERATIONS  4
+
+// Share of brightness a trail keeps per frame (see setTrails()), of 256
+#define PAZERVILLE_TRAIL_KEEP  200
+
+// Level-of-detail controller (see setFrameBudget())
+#define PAZERVILLE_LOD_RAISE_FRAMES  3     // frames over budget before dropping detail
+#define PAZERVILLE_LOD_LOWER_FRAMES  30    // frames with headroom before restoring it
+#define PAZERVILLE_LOD_HEADROOM      0.6f  // cost / budget below which detail comes back
+#define PAZERVILLE_LOD_MIN_EDGE      8     // edges shorter than this are culled, pixels
+
+// Physics governor defaults (see setPhysicsGovernor())
+#define PAZERVILLE_PHYSICS_SUBSTEPS     2      // update() steps per simulate() call
+#define PAZERVILLE_PHYSICS_FRAME_US     16667  // frame period assumed without a frame budget
+#define PAZERVILLE_PHYSICS_MAX_STRETCH  2.0f   // longest step, in time steps
+
+// Touch hit testing (see findNodeAt()): nodes are bucketed by centre into
+// a grid of square cells
+#define PAZERVILLE_HIT_CELL     32  // cell size, pixels
+#define PAZERVILLE_HIT_SLOP     8   // reach beyond a node's radius, pixels
+#define PAZERVILLE_HIT_COLUMNS  ((PAZERVILLE_WIDTH + PAZERVILLE_HIT_CELL - 1) / PAZERVILLE_HIT_CELL)
+#define PAZERVILLE_HIT_ROWS     ((PAZERVILLE_HEIGHT + PAZERVILLE_HIT_CELL - 1) / PAZERVILLE_HIT_CELL)
 
 // Pazerville graph node structure
 typedef struct {
@@ -17,9 +62,14 @@ typedef struct {
     float vx;  // velocity x
     float vy;  // velocity y
     float mass;
+    float inv_mass;  // 1 / mass, kept in sync by addNode/loadLayout
     uint16_t color;
     uint8_t radius;
     bool active;
+    bool frozen;          // held in place and skipped by integration
+    bool asleep;          // settled; skipped until a large enough force arrives
+    uint8_t calm_steps;   // consecutive steps below the settle speed
+    uint16_t generation;  // bumped whenever the slot is removed or reused
     int id;
 } PazervilleNode;
 
@@ -27,54 +77,403 @@ typedef struct {
 typedef struct {
     int node1;
     int node2;
+    uint16_t node1_generation;  // endpoint generations when the edge was made
+    uint16_t node2_generation;
     float spring_constant;
     float rest_length;
+    float compliance;           // constraint solvers: < 0 follows 1 / spring_constant (slack at 0), 0 = rigid
     uint16_t color;
     bool active;
+    uint16_t generation;
 } PazervilleEdge;
 
+// Morph track states
+#define PAZERVILLE_MORPH_NONE      0  // untouched by the current morph
+#define PAZERVILLE_MORPH_KEEP      1  // present in both graphs, properties blend
+#define PAZERVILLE_MORPH_FADE_IN   2  // new in the target graph
+#define PAZERVILLE_MORPH_FADE_OUT  3  // removed when the morph completes
+
+// Per-element interpolation during morphTo(). 'size' is the radius for
+// nodes and the spring constant for edges.
+typedef struct {
+    uint8_t state;
+    bool froze;           // node frozen by the morph, thawed when it ends
+    uint16_t from_color;
+    uint16_t to_color;
+    float from_size;
+    float to_size;
+} PazervilleMorphTrack;
+
+// Force field types evaluated inside the integration pass
+typedef enum {
+    PAZERVILLE_FIELD_RADIAL,     // constant push (+) or pull (-) along the line from (x, y)
+    PAZERVILLE_FIELD_ATTRACTOR,  // strength / distance toward (x, y), like attractToPoint()
+    PAZERVILLE_FIELD_VORTEX,     // tangential swirl around (x, y), counter-clockwise if positive
+    PAZERVILLE_FIELD_WIND        // uniform force along (x, y) scaled by strength
+} PazervilleFieldType;
+
+// How edges act on their nodes
+typedef enum {
+    PAZERVILLE_SOLVER_SPRINGS,       // spring forces, explicit integration (default)
+    PAZERVILLE_SOLVER_XPBD,          // distance constraints, Gauss-Seidel over the edges
+    PAZERVILLE_SOLVER_XPBD_JACOBI    // distance constraints, averaged Jacobi passes
+} PazervilleSolver;
+
+// Detail levels, cheapest last. Each level keeps the savings of the ones
+// before it.
+typedef enum {
+    PAZERVILLE_LOD_FULL,         // everything as configured
+    PAZERVILLE_LOD_NO_AA,        // aliased edges, HUD refreshed every other frame
+    PAZERVILLE_LOD_FLAT_NODES,   // no node outlines or rims
+    PAZERVILLE_LOD_CULL_EDGES,   // edges shorter than PAZERVILLE_LOD_MIN_EDGE skipped
+    PAZERVILLE_LOD_POINT_NODES,  // nodes as single pixels
+    PAZERVILLE_LOD_HALF_RATE     // the graph is redrawn every other frame
+} PazervilleLOD;
+
+// Pazerville force field structure
+typedef struct {
+    PazervilleFieldType type;
+    float x;
+    float y;
+    float strength;
+    float range;         // ignore nodes farther than this from (x, y); 0 = unlimited
+    int first_node;      // affected node range [first_node, last_node)
+    int last_node;       // -1 = up to the last node
+    bool mass_scaled;    // divide by node mass, as repelNode() does
+    bool active;
+} PazervilleForceField;
+
+// Precomputed layout entries (see tools/bake_layout.cpp)
+typedef struct {
+    float x;
+    float y;
+    float mass;
+    uint16_t color;
+    uint8_t radius;
+} PazervilleLayoutNode;
+
+typedef struct {
+    int node1;
+    int node2;
+    float spring_constant;
+    float rest_length;
+    uint16_t color;
+} PazervilleLayoutEdge;
+
+// A settled graph stored as constant tables in flash
+typedef struct {
+    const PazervilleLayoutNode *nodes;
+    int node_count;
+    const PazervilleLayoutEdge *edges;
+    int edge_count;
+} PazervilleLayout;
+
 // Pazerville renderer class
 class PazervilleDisplay {
 private:
     ILI9341Display *display;
     PazervilleNode nodes[PAZERVILLE_MAX_NODES];
     PazervilleEdge edges[PAZERVILLE_MAX_EDGES];
-    int node_count;
+    PazervilleForceField fields[PAZERVILLE_MAX_FIELDS];
+    float impulse_x[PAZERVILLE_MAX_NODES];
+    float impulse_y[PAZERVILLE_MAX_NODES];
+    int node_next_free[PAZERVILLE_MAX_NODES];
+    int edge_next_free[PAZERVILLE_MAX_EDGES];
+    int node_count;         // slot high-water mark, bounds iteration
     int edge_count;
+    int active_node_count;
+    int active_edge_count;
+    int node_free_head;
+    int edge_free_head;
+    uint32_t topology_revision;
+    int field_count;
+    bool has_impulses;
     float damping;
     float gravity;
     float time_step;
+    PazervilleSolver solver;
+    int solver_iterations;
     bool is_initialized;
     
+    // Topology morph state
+    PazervilleMorphTrack node_morph[PAZERVILLE_MAX_NODES];
+    PazervilleMorphTrack edge_morph[PAZERVILLE_MAX_EDGES];
+    int morph_step;
+    int morph_steps;          // 0 when no morph is running
+    
+    // Active-set scheduling
+    bool active_set;
+    float settle_speed;
+    int settle_hops;
+    int awake_node_count;
+    PazervilleForceField field_seen[PAZERVILLE_MAX_FIELDS];   // fields as of the last step
+    
+    // Node collisions. sweep_order lists the active nodes by left extent
+    // (x - radius) and is kept sorted from step to step.
+    bool collisions;
+    float restitution;
+    uint8_t sweep_order[PAZERVILLE_MAX_NODES];
+    int sweep_count;
+    int collision_pairs;      // narrow-phase tests in the last step
+    
+    // Render resolution follows graph size when enabled
+    bool auto_resolution;
+    int half_res_nodes;
+    int half_res_edges;
+    
+    // Node images
+    PazervilleSpriteCache sprites;
+    PazervilleNodeStyle node_style;
+    bool sprite_nodes;
+    bool smooth_edges;
+    
+    // Motion trails: the frame is faded instead of cleared
+    bool trails;
+    uint8_t trail_keep;
+    
+    // Statistics overlay
+    PazervilleHUD hud;
+    bool hud_enabled;
+    int hud_fields[5];        // FPS, step time, nodes, edges, energy
+    uint32_t last_draw_us;
+    float fps;
+    float step_time_us;
+    
+    // Level of detail, driven by the measured raster and flush time
+    uint32_t frame_budget_us;  // 0 = controller off
+    PazervilleLOD lod;
+    int lod_over;              // consecutive frames over budget
+    int lod_under;             // consecutive frames with headroom
+    uint32_t frame_count;
+    float raster_time_us;
+    float flush_time_us;
+    float frame_cost_us;       // raster + flush, smoothed; 0 = reseed
+    
+    // Physics governor: simulate() spends at most physics_share of a frame
+    uint8_t physics_substeps;
+    float physics_share;       // 0 = always run every substep
+    float physics_credit_us;   // unspent budget carried to the next frame
+    float physics_owed;        // simulated seconds not yet stepped
+    uint8_t last_substeps;
+    bool physics_degraded;
+    uint32_t degraded_frames;
+    
+    // Touch hit grid, rebuilt by the first query after nodes move
+    int16_t hit_head[PAZERVILLE_HIT_COLUMNS * PAZERVILLE_HIT_ROWS];
+    int16_t hit_next[PAZERVILLE_MAX_NODES];
+    uint8_t hit_reach;         // largest node radius in the grid
+    bool hit_grid_valid;
+    uint32_t hit_grid_revision;
+    
+    // Node dragging
+    int drag_node;             // -1 when nothing is held
+    uint16_t drag_generation;
+    bool drag_was_frozen;
+    float drag_vx;             // pointer velocity, smoothed, kept on release
+    float drag_vy;
+    uint32_t drag_time_us;
+    bool touch_held;           // pen down, whether or not it caught a node
+    bool touch_pending;        // a drag move not yet on screen
+    uint32_t touch_sample_us;  // sample time of that move
+    float touch_latency_us;
+    float last_touch_latency_us;
+    
+    // Changes posted from other contexts, applied by update() or simulate()
+    PazervilleCommandQueue commands;
+    int commands_applied;      // in the last batch
+    
+    // Slot management
+    int allocNode();
+    int allocEdge();
+    void releaseEdge(int idx);
+    bool edgeEndpointsValid(const PazervilleEdge &edge) const;
+    
+    // Active-set scheduling
+    void wakeNode(int idx) { nodes[idx].asleep = false; nodes[idx].calm_steps = 0; }
+    void wakeNeighbourhoods(const uint8_t *hot);
+    void wakeChangedFields();
+    
+    // Topology morphing
+    void advanceMorph();
+    void finishMorph();
+    
     // Physics simulation
     void updateNodePhysics();
+    void updateConstraintPhysics();
     void applySpringForces();
-    void applyDamping();
-    void constrainNodes();
+    void applyForceFields(PazervilleNode &node, int idx);
+    void constrainNode(PazervilleNode &node);
+    void resolveCollisions();
+    void collideNodes(int a, int b);
     void drawNode(const PazervilleNode &node);
-    void drawEdge(const PazervilleNode &n1, const PazervilleNode &n2, const PazervilleEdge &edge);
+    void drawEdges();
+    void updateHUD();
+    void updateLOD(uint32_t cost_us);
+    void step();
+    void buildHitGrid();
+    void applyCommands();
+    void applyCommand(const PazervilleCommand &command);
     
 public:
     PazervilleDisplay(ILI9341Display *tft_display);
     ~PazervilleDisplay();
     
     bool initialize();
-    void addNode(float x, float y, float mass, uint16_t color = COLOR_WHITE, uint8_t radius = 3);
-    void addEdge(int node1, int node2, float spring_constant = 0.01f, float rest_length = 50.0f);
+    PazervilleHandle addNode(float x, float y, float mass, uint16_t color = COLOR_WHITE, uint8_t radius = 3);
+    PazervilleHandle addEdge(int node1, int node2, float spring_constant = 0.01f, float rest_length = 50.0f);
+    PazervilleHandle addEdge(PazervilleHandle node1, PazervilleHandle node2, float spring_constant = 0.01f, float rest_length = 50.0f);
+    bool loadLayout(const PazervilleLayout &layout);
     void update();
     void draw();
+    void simulate();
     void setDamping(float d) { damping = d; }
-    void setGravity(float g) { gravity = g; }
+    void setGravity(float g) { if (g != gravity) { gravity = g; wakeAll(); } }
     void setTimeStep(float ts) { time_step = ts; }
     
+    // Constant-time graph mutation
+    bool removeNode(PazervilleHandle handle);
+    bool removeEdge(PazervilleHandle handle);
+    bool setEdgeCompliance(PazervilleHandle handle, float compliance);
+    void clear();
+    bool isValidNode(PazervilleHandle handle) const;
+    bool isValidEdge(PazervilleHandle handle) const;
+    PazervilleHandle getNodeHandle(int idx) const;
+    
+    // Incremented on every structural change, for caches built over the graph
+    uint32_t getTopologyRevision() const { return topology_revision; }
+    
+    // Deferred changes. Interrupts and other producers post to the queue
+    // instead of calling the setters. Everything posted so far is applied
+    // in order at the start of update(), or once per frame at the start of
+    // simulate() before its substeps. See PazervilleCommandQueue.
+    PazervilleCommandQueue& getCommands() { return commands; }
+    int getCommandsApplied() const { return commands_applied; }
+    
+    // Incremental transition to another graph over 'steps' update() calls;
+    // falls back to loadLayout() when the new edges do not fit
+    bool morphTo(const PazervilleLayout &target, int steps = 60);
+    bool isMorphing() const { return morph_steps > 0; }
+    
+    // Active-set scheduling: nodes that stay below 'speed' for
+    // PAZERVILLE_SETTLE_STEPS go to sleep and cost nothing until a neighbour
+    // pulls on them hard enough, or one within 'hops' edges starts moving
+    void setActiveSet(bool enabled, float speed = PAZERVILLE_SETTLE_SPEED, int hops = PAZERVILLE_SETTLE_HOPS);
+    void wakeAll();
+    int getAwakeNodeCount() const { return awake_node_count; }
+    
+    // Edge solver. The XPBD modes treat edges as distance constraints with
+    // compliance (inverse stiffness; 0 = rigid), solved 'iterations' times
+    // per step, so stiff chains and grids stay stable at one large step per
+    // frame. Sleeping is not used by the constraint solvers.
+    void setSolver(PazervilleSolver mode, int iterations = PAZERVILLE_SOLVER_ITERATIONS);
+    PazervilleSolver getSolver() const { return solver; }
+    
+    // Node-node collisions: nodes bounce off each other at the sum of their
+    // radii, exchanging momentum by mass. Independent of force fields and
+    // repelNode(). A sweep over x finds candidate pairs; for a layout that
+    // barely moves, keeping the sweep sorted costs close to one pass.
+    void setCollisions(bool enabled, float restitution = PAZERVILLE_COLLISION_RESTITUTION);
+    bool getCollisions() const { return collisions; }
+    int getCollisionPairs() const { return collision_pairs; }
+    
+    // Render at 160x120 while the graph has at least 'nodes' nodes or
+    // 'edges' edges, and at full resolution otherwise
+    void setAutoResolution(bool enabled, int nodes = PAZERVILLE_HALF_RES_NODES, int edges = PAZERVILLE_HALF_RES_EDGES);
+    
+    // Node appearance. Nodes are blitted from a cache of pre-rendered
+    // images unless disabled; radii above PAZERVILLE_SPRITE_MAX_RADIUS are
+    // always rasterized directly.
+    void setNodeStyle(PazervilleNodeStyle style) { node_style = style; }
+    PazervilleNodeStyle getNodeStyle() const { return node_style; }
+    void setSpriteCache(bool enabled) { sprite_nodes = enabled; }
+    PazervilleSpriteCache& getSpriteCache() { return sprites; }
+    
+    // Anti-aliased edges (on by default); RGB565 framebuffers only, indexed
+    // modes draw aliased edges either way
+    void setSmoothEdges(bool enabled) { smooth_edges = enabled; }
+    bool getSmoothEdges() const { return smooth_edges; }
+    
+    // Motion trails: each frame fades the previous one by keep / 256
+    // instead of clearing it, so moving nodes leave a fading track. Needs
+    // an RGB565 framebuffer; indexed modes keep clearing.
+    void setTrails(bool enabled, uint8_t keep = PAZERVILLE_TRAIL_KEEP) { trails = enabled; trail_keep = keep; }
+    bool getTrails() const { return trails; }
+    
+    // Statistics overlay: FPS, physics step time, node and edge counts and
+    // kinetic energy in a text band at the top of the screen. The graph is
+    // drawn below the band. Extra fields can be added through getHUD().
+    void setHUD(bool enabled);
+    PazervilleHUD& getHUD() { return hud; }
+    float getFPS() const { return fps; }
+    float getStepTime() const { return step_time_us; }  // microseconds per update(), smoothed
+    float getRasterTime() const { return raster_time_us; }  // microseconds per draw() into the framebuffer
+    float getFlushTime() const { return flush_time_us; }    // microseconds per updateDisplay()
+    
+    // Physics governor. simulate() advances the graph by 'substeps' time
+    // steps per frame, but spends at most 'share' of the frame on it (the
+    // frame budget, or PAZERVILLE_PHYSICS_FRAME_US without one). Over
+    // budget it runs fewer, longer steps, up to PAZERVILLE_PHYSICS_MAX_STRETCH
+    // time steps each; when even one step does not fit, steps are spread
+    // over several frames and the simulation runs slower than real time.
+    // A share of 0 always runs every substep.
+    void setPhysicsGovernor(uint8_t substeps, float share);
+    uint8_t getLastSubsteps() const { return last_substeps; }
+    bool isPhysicsDegraded() const { return physics_degraded; }   // last simulate() fell short
+    uint32_t getDegradedFrames() const { return degraded_frames; }
+    
+    // Frame-time budget for draw(), in microseconds. When a frame's raster
+    // plus flush time stays over it, detail is dropped one level at a
+    // time (see PazervilleLOD); with enough headroom it comes back. 0
+    // turns the controller off and restores full detail.
+    void setFrameBudget(uint32_t us);
+    uint32_t getFrameBudget() const { return frame_budget_us; }
+    PazervilleLOD getLOD() const { return lod; }
+    float getKineticEnergy() const;
+    
     // Interactive controls
     void repelNode(int node_id, float force_x, float force_y);
     void attractToPoint(int node_id, float target_x, float target_y, float strength);
     void randomizePositions();
     void resetSimulation();
     
+    // Touch: the nearest node whose radius plus 'slop' covers (x, y), or
+    // -1. Only nodes in the grid cells within reach are tested.
+    int findNodeAt(float x, float y, float slop = PAZERVILLE_HIT_SLOP);
+    
+    // Dragging holds a node at the pointer; its neighbours stay awake and
+    // follow. On release the node keeps the pointer's velocity and its
+    // previous frozen state.
+    bool beginDrag(int node_id);
+    void dragTo(float x, float y, uint32_t time_us);
+    void endDrag();
+    int getDragNode() const { return drag_node; }
+    
+    // Feed a touch point: a press picks up the node under it, moves drag
+    // it, and lifting drops it. Returns true while a node is held.
+    bool handleTouch(const PazervilleTouchPoint &point);
+    
+    // Time from the touch sample behind a drag move to the end of the
+    // flush that showed it, microseconds; smoothed and most recent
+    float getTouchLatency() const { return touch_latency_us; }
+    float getLastTouchLatency() const { return last_touch_latency_us; }
+    
+    // Force fields, applied to every node on every update() step
+    int addForceField(PazervilleFieldType type, float x, float y, float strength);
+    PazervilleForceField* getForceField(int idx) { return (idx >= 0 && idx < field_count) ? &fields[idx] : nullptr; }
+    void removeForceField(int idx);
+    void clearForceFields();
+    
+    // One-shot force applied on the next update() step only
+    void applyImpulse(int node_id, float force_x, float force_y);
+    
+    // Slot counts: iterate [0, count) and skip inactive entries
     int getNodeCount() const { return node_count; }
+    int getEdgeCount() const { return edge_count; }
+    int getActiveNodeCount() const { return active_node_count; }
+    int getActiveEdgeCount() const { return active_edge_count; }
     PazervilleNode* getNode(int idx) { return (idx >= 0 && idx < node_count) ? &nodes[idx] : nullptr; }
+    PazervilleEdge* getEdge(int idx) { return (idx >= 0 && idx < edge_count) ? &edges[idx] : nullptr; }
+    PazervilleNode* getNode(PazervilleHandle handle) { return isValidNode(handle) ? &nodes[handle.index] : nullptr; }
 };
 
 #endif // PAZERVILLE_DISPLAY_H
@@ -13,9 +13,10 @@ public:
         float center_y = PAZERVILLE_HEIGHT / 2.0f;
         
         for (int i = 0; i < num_nodes; i++) {
-            float angle = (2.0f * PI * i) / num_nodes;
-            float x = center_x + radius * cos(angle);
-            float y = center_y + radius * sin(angle);
+            float s, c;
+            pzSinCos((2.0f * (float)PI * i) / num_nodes, &s, &c);
+            float x = center_x + radius * c;
+            float y = center_y + radius * s;
             pazerville->addNode(x, y, 1.0f, getColorFromIndex(i), 4);
         }
         
@@ -35,9 +36,10 @@ public:
         
         // Add outer nodes
         for (int i = 0; i < num_outer_nodes; i++) {
-            float angle = (2.0f * PI * i) / num_outer_nodes;
-            float x = center_x + radius * cos(angle);
-            float y = center_y + radius * sin(angle);
+            float s, c;
+            pzSinCos((2.0f * (float)PI * i) / num_outer_nodes, &s, &c);
+            float x = center_x + radius * c;
+            float y = center_y + radius * s;
             pazerville->addNode(x, y, 1.0f, getColorFromIndex(i), 4);
         }
         
@@ -75,9 +77,10 @@ public:
         
         // Add nodes in circle
         for (int i = 0; i < num_nodes; i++) {
-            float angle = (2.0f * PI * i) / num_nodes;
-            float x = center_x + radius * cos(angle);
-            float y = center_y + radius * sin(angle);
+            float s, c;
+            pzSinCos((2.0f * (float)PI * i) / num_nodes, &s, &c);
+            float x = center_x + radius * c;
+            float y = center_y + radius * s;
             pazerville->addNode(x, y, 1.0f, getColorFromIndex(i), 4);
         }
         
@@ -169,8 +172,10 @@ public:
     // Helper: Convert angle to position
     static void polarToCartesian(float angle, float radius, float center_x, float center_y,
                                  float &x, float &y) {
-        x = center_x + radius * cos(angle);
-        y = center_y + radius * sin(angle);
+        float s, c;
+        pzSinCos(angle, &s, &c);
+        x = center_x + radius * c;
+        y = center_y + radius * s;
     }
     
 private:
@@ -0,0 +1,64 @@
+#ifndef PAZERVILLE_HUD_H
+#define PAZERVILLE_HUD_H
+
+#include "ili9341_display.h"
+
+// HUD configuration
+#define PAZERVILLE_HUD_MAX_FIELDS   8
+#define PAZERVILLE_HUD_FIELD_CHARS  12   // value characters per field
+#define PAZERVILLE_HUD_MAX_DECIMALS 6    // setFixed() limit, keeps the scaled value in int32_t
+
+// One labelled value. 'text' is what the caller last set, 'shown' is what
+// is in the framebuffer, space padded; render() only redraws the cells
+// where they differ.
+typedef struct {
+    const char *label;
+    uint16_t x;
+    uint16_t y;
+    uint16_t color;
+    char text[PAZERVILLE_HUD_FIELD_CHARS + 1];
+    char shown[PAZERVILLE_HUD_FIELD_CHARS + 1];
+    bool label_drawn;
+} PazervilleHUDField;
+
+// Change-driven text overlay.
+//
+// Fields are drawn into the framebuffer after the graph pass. The band of
+// rows they occupy is left alone by the graph, so a field whose value did
+// not change costs nothing, and one that did only redraws and dirties the
+// character cells that changed.
+class PazervilleHUD {
+private:
+    ILI9341Display *display;
+    PazervilleHUDField fields[PAZERVILLE_HUD_MAX_FIELDS];
+    int field_count;
+    uint16_t bg;
+    uint16_t top;      // band of rows covered by the fields
+    uint16_t bottom;
+    bool needs_clear;
+    
+public:
+    PazervilleHUD(ILI9341Display *tft_display);
+    
+    // Add a field at panel position (x, y); returns its index or -1 if full
+    int addField(const char *label, uint16_t x, uint16_t y, uint16_t color = COLOR_WHITE);
+    void clearFields();
+    
+    // Set a field's value; nothing is drawn until render()
+    void setText(int idx, const char *text);
+    void setInt(int idx, int32_t value, const char *suffix = "");
+    void setFixed(int idx, float value, uint8_t decimals, const char *suffix = "");
+    
+    // Draw labels and changed value cells
+    void render();
+    
+    // Forget what is on screen, e.g. after the framebuffer was cleared
+    void invalidate();
+    
+    void setBackground(uint16_t color) { bg = color; invalidate(); }
+    uint16_t getTop() const { return top; }
+    uint16_t getBottom() const { return bottom; }
+    int getFieldCount() const { return field_count; }
+};
+
+#endif // PAZERVILLE_HUD_H
@@ -0,0 +1,65 @@
+#ifndef PAZERVILLE_MAILBOX_H
+#define PAZERVILLE_MAILBOX_H
+
+#include <Arduino.h>
+
+// Set in the spare index when it holds a value the consumer has not taken
+#define PAZERVILLE_MAILBOX_FRESH 0x80
+
+// Triple-buffered mailbox for one producer and one consumer, latest value
+// wins. The producer fills slot() and publishes it; the consumer copies
+// out the newest published value. Each side owns one buffer and the third
+// is swapped through 'middle' with one atomic exchange, so neither side
+// ever waits or sees a half-written value, and the producer may be an
+// interrupt. Values published faster than they are read are overwritten.
+template <class T>
+class PazervilleMailbox {
+private:
+    T buffers[3];
+    uint8_t back;              // producer's buffer
+    uint8_t front;             // consumer's buffer
+    volatile uint8_t middle;   // spare buffer index | PAZERVILLE_MAILBOX_FRESH
+    
+public:
+    PazervilleMailbox();
+    
+    // Producer side: fill slot(), then publish() hands it over
+    T& slot() { return buffers[back]; }
+    void publish();
+    
+    // Consumer side: copies the newest value, returns false if nothing new
+    bool read(T *value);
+};
+
+// Constructor
+template <class T>
+PazervilleMailbox<T>::PazervilleMailbox() {
+    memset(buffers, 0, sizeof(buffers));
+    back = 0;
+    middle = 1;
+    front = 2;
+}
+
+// Swap the filled back buffer for the spare one. The release half orders
+// the writes to the buffer before the index that points at it.
+template <class T>
+void PazervilleMailbox<T>::publish() {
+    uint8_t spare = __atomic_exchange_n(&middle, (uint8_t)(back | PAZERVILLE_MAILBOX_FRESH), __ATOMIC_ACQ_REL);
+    back = spare & ~PAZERVILLE_MAILBOX_FRESH;
+}
+
+// Take the spare buffer if it is fresh. The acquire half orders the
+// producer's writes to it before the copy.
+template <class T>
+bool PazervilleMailbox<T>::read(T *value) {
+    if (!(__atomic_load_n(&middle, __ATOMIC_ACQUIRE) & PAZERVILLE_MAILBOX_FRESH)) {
+        return false;
+    }
+    
+    uint8_t fresh = __atomic_exchange_n(&middle, front, __ATOMIC_ACQ_REL);
+    front = fresh & ~PAZERVILLE_MAILBOX_FRESH;
+    *value = buffers[front];
+    return true;
+}
+
+#endif // PAZERVILLE_MAILBOX_H
@@ -0,0 +1,111 @@
+#ifndef PAZERVILLE_MATH_H
+#define PAZERVILLE_MATH_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// Float-only math for the physics hot path.
+//
+// Plain sqrt()/sin()/cos() on a float promote to double, which is a
+// software routine on the single-precision FPU of the Teensy 3.6. These
+// helpers stay in float and trade accuracy for speed by tier:
+//
+//   PAZERVILLE_MATH_EXACT    libm float functions (sqrtf, sinf, cosf)
+//   PAZERVILLE_MATH_REFINED  hardware vsqrt.f32, rsqrt + 2 Newton steps,
+//                            interpolated sine table (default)
+//   PAZERVILLE_MATH_FAST     rsqrt + 1 Newton step, nearest-entry sine table
+//
+// Select a tier with -DPAZERVILLE_MATH_PRECISION=<tier> in build_flags.
+#define PAZERVILLE_MATH_EXACT    0
+#define PAZERVILLE_MATH_REFINED  1
+#define PAZERVILLE_MATH_FAST     2
+
+#ifndef PAZERVILLE_MATH_PRECISION
+#define PAZERVILLE_MATH_PRECISION PAZERVILLE_MATH_REFINED
+#endif
+
+// Sine table: one full turn, power-of-two size so the phase wraps with a mask
+#define PZ_SIN_TABLE_SIZE  256
+#define PZ_SIN_TABLE_MASK  (PZ_SIN_TABLE_SIZE - 1)
+#define PZ_SIN_TABLE_SCALE (PZ_SIN_TABLE_SIZE / 6.28318530718f)
+
+extern const float pz_sin_table[PZ_SIN_TABLE_SIZE];
+
+// Initial 1/sqrt(x) estimate from the float bit pattern (~3.4% error)
+static inline float pzInvSqrtEstimate(float x) {
+    uint32_t i;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x5F3759DF - (i >> 1);
+    float y;
+    memcpy(&y, &i, sizeof(y));
+    return y;
+}
+
+// Reciprocal square root, x must be > 0
+static inline float pzInvSqrt(float x) {
+#if PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_EXACT
+    return 1.0f / sqrtf(x);
+#else
+    float half_x = 0.5f * x;
+    float y = pzInvSqrtEstimate(x);
+    y = y * (1.5f - half_x * y * y);
+#if PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_REFINED
+    y = y * (1.5f - half_x * y * y);
+#endif
+    return y;
+#endif
+}
+
+// Square root without promoting to double
+static inline float pzSqrt(float x) {
+#if PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_FAST
+    return (x > 0.0f) ? x * pzInvSqrt(x) : 0.0f;
+#elif PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_REFINED && defined(__ARM_FP) && (__ARM_FP & 4)
+    float r;
+    asm("vsqrt.f32 %0, %1" : "=t"(r) : "t"(x));
+    return r;
+#else
+    return sqrtf(x);
+#endif
+}
+
+// Sine and cosine of the same angle from one table lookup
+static inline void pzSinCos(float angle, float *s, float *c) {
+#if PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_EXACT
+    *s = sinf(angle);
+    *c = cosf(angle);
+#else
+    float phase = angle * PZ_SIN_TABLE_SCALE;
+    int32_t i = (int32_t)phase;
+    if (phase < (float)i) {
+        i--;  // floor for negative angles
+    }
+    uint32_t si = (uint32_t)i & PZ_SIN_TABLE_MASK;
+    uint32_t ci = (si + PZ_SIN_TABLE_SIZE / 4) & PZ_SIN_TABLE_MASK;
+#if PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_REFINED
+    float frac = phase - (float)i;
+    float s0 = pz_sin_table[si];
+    float c0 = pz_sin_table[ci];
+    *s = s0 + (pz_sin_table[(si + 1) & PZ_SIN_TABLE_MASK] - s0) * frac;
+    *c = c0 + (pz_sin_table[(ci + 1) & PZ_SIN_TABLE_MASK] - c0) * frac;
+#else
+    *s = pz_sin_table[si];
+    *c = pz_sin_table[ci];
+#endif
+#endif
+}
+
+static inline float pzSin(float angle) {
+    float s, c;
+    pzSinCos(angle, &s, &c);
+    return s;
+}
+
+static inline float pzCos(float angle) {
+    float s, c;
+    pzSinCos(angle, &s, &c);
+    return c;
+}
+
+#endif // PAZERVILLE_MATH_H
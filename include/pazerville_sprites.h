@@ -0,0 +1,56 @@
+#ifndef PAZERVILLE_SPRITES_H
+#define PAZERVILLE_SPRITES_H
+
+#include "ili9341_display.h"
+
+// Sprite cache configuration. Memory is fixed at
+// PAZERVILLE_SPRITE_SLOTS * (3 bytes * PAZERVILLE_SPRITE_MAX_SIZE^2).
+#define PAZERVILLE_SPRITE_SLOTS       12
+#define PAZERVILLE_SPRITE_MAX_RADIUS  8
+#define PAZERVILLE_SPRITE_MAX_SIZE    (2 * PAZERVILLE_SPRITE_MAX_RADIUS + 1)
+
+// How nodes are drawn
+typedef enum {
+    PAZERVILLE_NODE_CLASSIC,   // circle outline with a filled centre square
+    PAZERVILLE_NODE_DISC,      // filled disc
+    PAZERVILLE_NODE_DISC_AA,   // filled disc with anti-aliased edge (RGB565 framebuffers)
+    PAZERVILLE_NODE_OUTLINED   // filled disc with a white rim
+} PazervilleNodeStyle;
+
+// One pre-rendered node image
+typedef struct {
+    uint8_t radius;
+    uint16_t color;
+    uint8_t style;
+    bool valid;
+    uint32_t last_used;        // LRU stamp
+    ILI9341Sprite sprite;
+    uint16_t pixels[PAZERVILLE_SPRITE_MAX_SIZE * PAZERVILLE_SPRITE_MAX_SIZE];
+    uint8_t mask[PAZERVILLE_SPRITE_MAX_SIZE * PAZERVILLE_SPRITE_MAX_SIZE];
+} PazervilleSpriteSlot;
+
+// Node images keyed by (radius, colour, style). A miss renders the image
+// with its coverage mask into the least recently used slot, so any number
+// of combinations fits in the same fixed memory.
+class PazervilleSpriteCache {
+private:
+    PazervilleSpriteSlot slots[PAZERVILLE_SPRITE_SLOTS];
+    uint32_t clock;
+    uint32_t hits;
+    uint32_t misses;
+    
+    void render(PazervilleSpriteSlot &slot);
+    
+public:
+    PazervilleSpriteCache();
+    
+    // Image for a node, centred at (radius, radius); nullptr if the radius
+    // is larger than PAZERVILLE_SPRITE_MAX_RADIUS
+    const ILI9341Sprite* get(uint8_t radius, uint16_t color, PazervilleNodeStyle style);
+    void clear();
+    
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+};
+
+#endif // PAZERVILLE_SPRITES_H
@@ -0,0 +1,112 @@
+#ifndef PAZERVILLE_TOUCH_H
+#define PAZERVILLE_TOUCH_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "pazerville_mailbox.h"
+
+// Touch controller configuration
+#define PAZERVILLE_TOUCH_CS           6        // T_CS; shares SCK/MOSI/MISO with the panel
+#define PAZERVILLE_TOUCH_SPI_CLOCK    2000000  // the XPT2046 tops out near 2.5 MHz
+#define PAZERVILLE_TOUCH_SAMPLE_RATE  200      // Hz
+#define PAZERVILLE_TOUCH_FULL_SCALE   4095     // 12-bit conversions
+#define PAZERVILLE_TOUCH_PRESSURE     300      // minimum pressure for a press
+#define PAZERVILLE_TOUCH_DEBOUNCE     2        // agreeing samples before down/up changes
+#define PAZERVILLE_TOUCH_SMOOTHING    0.5f     // one-pole coefficient, 1.0 = unfiltered
+
+// Default raw range of a 2.8" ILI9341 module in landscape
+#define PAZERVILLE_TOUCH_RAW_X_MIN    3800
+#define PAZERVILLE_TOUCH_RAW_X_MAX    300
+#define PAZERVILLE_TOUCH_RAW_Y_MIN    3700
+#define PAZERVILLE_TOUCH_RAW_Y_MAX    400
+
+// XPT2046 control bytes: start bit, channel, 12-bit differential,
+// powered down with the pen interrupt enabled between conversions
+#define XPT2046_CMD_X   0xD0
+#define XPT2046_CMD_Y   0x90
+#define XPT2046_CMD_Z1  0xB0
+#define XPT2046_CMD_Z2  0xC0
+
+// Filtered touch state in screen coordinates
+typedef struct {
+    int16_t x;
+    int16_t y;
+    uint16_t pressure;     // 0 when released
+    bool down;             // debounced
+    uint32_t time_us;      // when the sample behind this point was taken
+    uint32_t sample_index; // increments once per accepted sample
+} PazervilleTouchPoint;
+
+// Scripted controller for hosts without one: returns the raw 12-bit
+// conversion the XPT2046 would give for 'command' at a given time
+typedef uint16_t (*PazervilleTouchSource)(uint8_t command, uint32_t time_us);
+
+// XPT2046 resistive touch controller on the display's SPI bus.
+//
+// sampleTick() reads the controller, from a timer interrupt or by hand.
+// While ili9341_bus_busy is set it never selects the controller; it asks
+// for the bus with ili9341_requestBus() instead, and the flush hands it
+// over at its next row boundary. Each accepted sample is the median of
+// three conversions per axis, debounced on pressure and smoothed, then
+// published through a PazervilleMailbox.
+class PazervilleTouch {
+private:
+    uint8_t cs_pin;
+    PazervilleTouchSource source;
+    uint32_t sample_rate;
+    
+    // Calibration: raw readings at the left/right and top/bottom edges
+    uint16_t raw_x_min, raw_x_max;
+    uint16_t raw_y_min, raw_y_max;
+    uint16_t width, height;
+    
+    // Filter state, owned by the sampler
+    float smoothing;
+    uint16_t pressure_threshold;
+    float filtered_x, filtered_y;
+    bool down;
+    uint8_t disagree;          // consecutive samples contradicting 'down'
+    uint32_t sample_count;
+    volatile uint32_t deferred_ticks;
+    volatile bool sampling;    // a sample is being taken
+    
+    PazervilleMailbox<PazervilleTouchPoint> points;
+    
+    uint16_t convert(uint8_t command, uint32_t now);
+    uint16_t convertMedian(uint8_t command, uint32_t now);
+    int32_t readPressure(uint32_t now);
+    void select();
+    void deselect();
+    bool probe();
+    void sample();
+    
+public:
+    PazervilleTouch();
+    
+    // Start background sampling (Teensy only); without it, call sampleTick().
+    // False if no controller answers, or if the pen is down at the time.
+    bool begin(uint8_t cs = PAZERVILLE_TOUCH_CS, uint32_t rate = PAZERVILLE_TOUCH_SAMPLE_RATE);
+    void end();
+    
+    // Replace the controller with a scripted source (host replay)
+    void setSource(PazervilleTouchSource src) { source = src; }
+    
+    // Map raw readings to a width x height screen; min and max may be
+    // swapped to flip an axis
+    void setCalibration(uint16_t x_min, uint16_t x_max, uint16_t y_min, uint16_t y_max,
+                        uint16_t w = 320, uint16_t h = 240);
+    void setSmoothing(float s) { smoothing = s; }
+    void setPressureThreshold(uint16_t p) { pressure_threshold = p; }
+    
+    // Producer side: one sample; called from the timer ISR, or by hand
+    void sampleTick();
+    
+    // Consumer side: copies the newest point, returns false if nothing new
+    bool read(PazervilleTouchPoint *point) { return points.read(point); }
+    
+    // Ticks that found the display holding the bus
+    uint32_t getDeferredTicks() const { return deferred_ticks; }
+    uint32_t getSampleRate() const { return sample_rate; }
+};
+
+#endif // PAZERVILLE_TOUCH_H
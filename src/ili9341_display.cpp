@@ -1,51 +1,141 @@
 #include "../include/ili9341_display.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Blend a run of pixels. The packed-word form of ili9341Blend() already
+// scales all three channels with one multiply, which is the best the
+// Cortex-M7 can do (its DSP multiplies only take two halfwords), so the
+// device runs it as is. Hosts with SSE2 do four pixels per step in 32-bit
+// lanes with exactly the same arithmetic.
+void ili9341BlendRun(uint16_t *dst, const uint16_t *src, const uint8_t *alpha, uint32_t count) {
+    uint32_t i = 0;
+    
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi32(0x07E0F81F);
+    const __m128i round = _mm_set1_epi32(4);
+    for (; i + 4 <= count; i += 4) {
+        __m128i f = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)&src[i]), zero);
+        __m128i b = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)&dst[i]), zero);
+        __m128i a = _mm_cvtsi32_si128(*(const int32_t *)&alpha[i]);
+        a = _mm_unpacklo_epi16(_mm_unpacklo_epi8(a, zero), zero);
+        a = _mm_srli_epi32(_mm_add_epi32(a, round), 3);
+        f = _mm_and_si128(_mm_or_si128(f, _mm_slli_epi32(f, 16)), mask);
+        b = _mm_and_si128(_mm_or_si128(b, _mm_slli_epi32(b, 16)), mask);
+        
+        // 32 x 32 multiply, low words, from the two even/odd 64-bit products
+        __m128i d = _mm_sub_epi32(f, b);
+        __m128i even = _mm_mul_epu32(d, a);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(d, 32), _mm_srli_epi64(a, 32));
+        __m128i p = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                       _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        
+        __m128i r = _mm_and_si128(_mm_add_epi32(_mm_srli_epi32(p, 5), b), mask);
+        r = _mm_or_si128(r, _mm_srli_epi32(r, 16));
+        
+        // Sign-extend the low halves so the saturating pack keeps them intact
+        r = _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+        _mm_storel_epi64((__m128i *)&dst[i], _mm_packs_epi32(r, r));
+    }
+#endif
+
+    for (; i < count; i++) {
+        dst[i] = ili9341Blend(src[i], dst[i], alpha[i]);
+    }
+}
+
+// Decay a run of pixels. Scaling the spread channels by at most 31 cannot
+// carry between fields, so the packed word gives exact per-channel floors;
+// SSE2 does the same per channel in 16-bit lanes, eight pixels at a time.
+void ili9341DecayRun(uint16_t *pixels, uint8_t keep, uint32_t count) {
+    uint32_t i = 0;
+    
+#if defined(__SSE2__)
+    const __m128i k = _mm_set1_epi16(keep);
+    const __m128i low5 = _mm_set1_epi16(0x1F);
+    const __m128i low6 = _mm_set1_epi16(0x3F);
+    for (; i + 8 <= count; i += 8) {
+        __m128i p = _mm_loadu_si128((const __m128i *)&pixels[i]);
+        __m128i r = _mm_srli_epi16(_mm_mullo_epi16(_mm_srli_epi16(p, 11), k), 5);
+        __m128i g = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(p, 5), low6), k), 5);
+        __m128i b = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(p, low5), k), 5);
+        p = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+        _mm_storeu_si128((__m128i *)&pixels[i], p);
+    }
+#endif
+
+    for (; i < count; i++) {
+        uint32_t c = (pixels[i] | ((uint32_t)pixels[i] << 16)) & 0x07E0F81F;
+        c = ((c * keep) >> 5) & 0x07E0F81F;
+        pixels[i] = (uint16_t)(c | (c >> 16));
+    }
+}
+
 // Constructor
-ILI9341Display::ILI9341Display() {
+template <class Transport>
+ILI9341Driver<Transport>::ILI9341Driver() {
     buffer.width = ILI9341_WIDTH;
     buffer.height = ILI9341_HEIGHT;
+    buffer.shift_x = 0;
+    buffer.shift_y = 0;
+    buffer.capacity = 0;
+    resolution = ILI9341_RES_FULL;
     buffer.framebuffer = nullptr;
+    buffer.index_buffer = nullptr;
     buffer.dirty_lines = nullptr;
+    buffer.dirty_x0 = nullptr;
+    buffer.dirty_x1 = nullptr;
+    buffer.lit_x0 = nullptr;
+    buffer.lit_x1 = nullptr;
+    buffer.color_mode = ILI9341_COLOR_RGB565;
     buffer.is_initialized = false;
-    spi_speed = 40000000;  // 40 MHz SPI speed
+    partial_mode = false;
+    partial_first = 0;
+    partial_last = ILI9341_GATE_LINES - 1;
+    scroll_left = 0;
+    scroll_width = 0;
+    scroll_offset = 0;
+    palette_used = 0;
+    palette_limit = ILI9341_PALETTE_SIZE;
+    cache_valid = 0;
+    clearClipRect();
+    font = &ili9341_font5x7;
+    for (uint16_t i = 0; i < ILI9341_GLYPH_CACHE; i++) {
+        glyph_cache[i].font = nullptr;
+    }
 }
 
 // Destructor
-ILI9341Display::~ILI9341Display() {
+template <class Transport>
+ILI9341Driver<Transport>::~ILI9341Driver() {
     if (buffer.framebuffer) {
         delete[] buffer.framebuffer;
     }
+    if (buffer.index_buffer) {
+        delete[] buffer.index_buffer;
+    }
     if (buffer.dirty_lines) {
         delete[] buffer.dirty_lines;
     }
-}
-
-// Write command to display
-void ILI9341Display::writeCommand(uint8_t cmd) {
-    digitalWrite(TFT_DC, LOW);
-    SPI.transfer(cmd);
-}
-
-// Write data byte to display
-void ILI9341Display::writeData(uint8_t data) {
-    digitalWrite(TFT_DC, HIGH);
-    SPI.transfer(data);
-}
-
-// Write 16-bit data to display
-void ILI9341Display::writeData16(uint16_t data) {
-    digitalWrite(TFT_DC, HIGH);
-    SPI.transfer16(data);
-}
-
-// Read data from display
-uint8_t ILI9341Display::readData(void) {
-    digitalWrite(TFT_DC, HIGH);
-    return SPI.transfer(0);
+    if (buffer.dirty_x0) {
+        delete[] buffer.dirty_x0;
+    }
+    if (buffer.dirty_x1) {
+        delete[] buffer.dirty_x1;
+    }
+    if (buffer.lit_x0) {
+        delete[] buffer.lit_x0;
+    }
+    if (buffer.lit_x1) {
+        delete[] buffer.lit_x1;
+    }
 }
 
 // Set the address window for drawing
-void ILI9341Display::setAddressWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+template <class Transport>
+void ILI9341Driver<Transport>::setAddressWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
     // Column address set
     writeCommand(ILI9341_COLADDRSET);
     writeData16(x0);
@@ -58,33 +148,71 @@ void ILI9341Display::setAddressWindow(uint16_t x0, uint16_t y0, uint16_t x1, uin
 }
 
 // Initialize the display
-bool ILI9341Display::initialize() {
-    pinMode(TFT_CS, OUTPUT);
-    pinMode(TFT_DC, OUTPUT);
+template <class Transport>
+bool ILI9341Driver<Transport>::initialize(ILI9341ColorMode mode, ILI9341Resolution res) {
     pinMode(TFT_RST, OUTPUT);
     
-    // Allocate framebuffer
-    buffer.framebuffer = new uint16_t[ILI9341_WIDTH * ILI9341_HEIGHT];
-    if (!buffer.framebuffer) {
-        return false;
+    // Allocate framebuffer in the requested format, sized for the
+    // requested render target
+    buffer.color_mode = mode;
+    buffer.capacity = (uint32_t)ILI9341_WIDTH * ILI9341_HEIGHT;
+    if (res == ILI9341_RES_HALF) {
+        buffer.capacity /= 4;
+    } else if (res == ILI9341_RES_HALF_WIDTH) {
+        buffer.capacity /= 2;
+    }
+    
+    if (mode == ILI9341_COLOR_RGB565) {
+        buffer.framebuffer = new uint16_t[buffer.capacity];
+        if (!buffer.framebuffer) {
+            return false;
+        }
+    } else {
+        uint32_t bytes = buffer.capacity;
+        if (mode == ILI9341_COLOR_INDEXED4) {
+            bytes /= 2;
+        }
+        buffer.index_buffer = new uint8_t[bytes];
+        if (!buffer.index_buffer) {
+            return false;
+        }
+        
+        // Start with the named colours so common drawing never searches
+        static const uint16_t named[] = {
+            COLOR_BLACK, COLOR_WHITE, COLOR_RED, COLOR_GREEN, COLOR_BLUE,
+            COLOR_CYAN, COLOR_MAGENTA, COLOR_YELLOW, COLOR_GRAY, COLOR_ORANGE
+        };
+        palette_limit = (mode == ILI9341_COLOR_INDEXED4) ? 16 : ILI9341_PALETTE_SIZE;
+        palette_used = 0;
+        cache_valid = 0;
+        for (uint16_t i = 0; i < sizeof(named) / sizeof(named[0]); i++) {
+            setPaletteEntry(i, named[i]);
+        }
     }
     
     // Allocate dirty line tracking
     buffer.dirty_lines = new uint16_t[ILI9341_HEIGHT];
-    if (!buffer.dirty_lines) {
+    buffer.dirty_x0 = new uint16_t[ILI9341_HEIGHT];
+    buffer.dirty_x1 = new uint16_t[ILI9341_HEIGHT];
+    buffer.lit_x0 = new uint16_t[ILI9341_HEIGHT];
+    buffer.lit_x1 = new uint16_t[ILI9341_HEIGHT];
+    if (!buffer.dirty_lines || !buffer.dirty_x0 || !buffer.dirty_x1 ||
+        !buffer.lit_x0 || !buffer.lit_x1) {
         return false;
     }
+    for (uint16_t y = 0; y < ILI9341_HEIGHT; y++) {
+        buffer.lit_x0[y] = 1;
+        buffer.lit_x1[y] = 0;
+    }
+    setResolution(res);
     
-    // Initialize SPI
-    SPI.begin();
-    SPI.setClockDivider(SPI_CLOCK_DIV2);
-    SPI.setBitOrder(MSBFIRST);
-    SPI.setDataMode(SPI_MODE0);
+    // Initialize the bus
+    bus.begin();
     
     // Reset display
     reset();
     
-    digitalWrite(TFT_CS, LOW);
+    bus.beginTransaction();
     
     // Software reset
     writeCommand(ILI9341_SOFTRESET);
@@ -134,21 +262,22 @@ bool ILI9341Display::initialize() {
     // Invert on
     writeCommand(ILI9341_INVERTON);
     
-    // Display on
-    displayOn();
+    // Display on, inside the same transaction
+    writeCommand(ILI9341_DISPLAYON);
     
-    // Clear screen
-    fillScreen(COLOR_BLACK);
+    bus.endTransaction();
     
+    // Clear screen
     buffer.is_initialized = true;
-    
-    digitalWrite(TFT_CS, HIGH);
+    fillScreen(COLOR_BLACK);
+    updateDisplay();
     
     return true;
 }
 
 // Reset the display
-void ILI9341Display::reset() {
+template <class Transport>
+void ILI9341Driver<Transport>::reset() {
     digitalWrite(TFT_RST, HIGH);
     delay(100);
     digitalWrite(TFT_RST, LOW);
@@ -158,22 +287,25 @@ void ILI9341Display::reset() {
 }
 
 // Turn display on
-void ILI9341Display::displayOn() {
-    digitalWrite(TFT_CS, LOW);
+template <class Transport>
+void ILI9341Driver<Transport>::displayOn() {
+    bus.beginTransaction();
     writeCommand(ILI9341_DISPLAYON);
-    digitalWrite(TFT_CS, HIGH);
+    bus.endTransaction();
 }
 
 // Turn display off
-void ILI9341Display::displayOff() {
-    digitalWrite(TFT_CS, LOW);
+template <class Transport>
+void ILI9341Driver<Transport>::displayOff() {
+    bus.beginTransaction();
     writeCommand(ILI9341_DISPLAYOFF);
-    digitalWrite(TFT_CS, HIGH);
+    bus.endTransaction();
 }
 
 // Set display rotation
-void ILI9341Display::setRotation(uint8_t rotation) {
-    digitalWrite(TFT_CS, LOW);
+template <class Transport>
+void ILI9341Driver<Transport>::setRotation(uint8_t rotation) {
+    bus.beginTransaction();
     writeCommand(ILI9341_ENTRYMODE);
     
     switch (rotation) {
@@ -191,53 +323,359 @@ void ILI9341Display::setRotation(uint8_t rotation) {
             break;
     }
     
-    digitalWrite(TFT_CS, HIGH);
+    bus.endTransaction();
 }
 
-// Fill entire screen with a color
-void ILI9341Display::fillScreen(uint16_t color) {
-    fillRect(0, 0, ILI9341_WIDTH, ILI9341_HEIGHT, color);
+// Enter partial display mode; gate lines (columns) outside first - last
+// are not driven
+template <class Transport>
+void ILI9341Driver<Transport>::enterPartialMode(uint16_t first, uint16_t last) {
+    if (last >= ILI9341_GATE_LINES) last = ILI9341_GATE_LINES - 1;
+    if (first > last) return;
+    
+    partial_first = first;
+    partial_last = last;
+    partial_mode = true;
+    
+    bus.beginTransaction();
+    writeCommand(ILI9341_PARTIALAREA);
+    writeData16(first);
+    writeData16(last);
+    writeCommand(ILI9341_PARTIALON);
+    bus.endTransaction();
 }
 
-// Fill a rectangle with a color
-void ILI9341Display::fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
-    if ((x + w - 1) >= ILI9341_WIDTH) {
-        w = ILI9341_WIDTH - x;
-    }
-    if ((y + h - 1) >= ILI9341_HEIGHT) {
-        h = ILI9341_HEIGHT - y;
-    }
+// Return to normal display mode
+template <class Transport>
+void ILI9341Driver<Transport>::exitPartialMode() {
+    partial_mode = false;
+    partial_first = 0;
+    partial_last = ILI9341_GATE_LINES - 1;
     
-    setAddressWindow(x, y, x + w - 1, y + h - 1);
+    bus.beginTransaction();
+    writeCommand(ILI9341_NORMALON);
+    bus.endTransaction();
+}
+
+// Define a band of columns that scrolls in hardware. VSCRDEF counts gate
+// lines, and the fixed areas either side must add up to all of them with
+// the scroll area.
+template <class Transport>
+void ILI9341Driver<Transport>::setScrollArea(uint16_t left, uint16_t width) {
+    if (left + width > ILI9341_GATE_LINES || width == 0) return;
+    
+    scroll_left = left;
+    scroll_width = width;
+    scroll_offset = 0;
+    
+    bus.beginTransaction();
+    writeCommand(ILI9341_VSCRDEF);
+    writeData16(left);
+    writeData16(width);
+    writeData16(ILI9341_GATE_LINES - left - width);
+    bus.endTransaction();
+    
+    setScrollStart(0);
+}
+
+// Remove the scroll area; the whole panel is fixed again
+template <class Transport>
+void ILI9341Driver<Transport>::clearScrollArea() {
+    scroll_width = 0;
+    scroll_offset = 0;
+    
+    bus.beginTransaction();
+    writeCommand(ILI9341_VSCRDEF);
+    writeData16(0);
+    writeData16(ILI9341_GATE_LINES);
+    writeData16(0);
+    writeCommand(ILI9341_VSCRSADD);
+    writeData16(0);
+    bus.endTransaction();
+}
+
+// Show the scroll area starting from memory column scroll_left + offset
+template <class Transport>
+void ILI9341Driver<Transport>::setScrollStart(uint16_t offset) {
+    if (scroll_width == 0) return;
+    
+    scroll_offset = offset % scroll_width;
+    
+    bus.beginTransaction();
+    writeCommand(ILI9341_VSCRSADD);
+    writeData16(scroll_left + scroll_offset);
+    bus.endTransaction();
+}
+
+// Append one column (ILI9341_HEIGHT pixels, top to bottom) at the right
+// of the scroll area. Only this column and the scroll register are sent;
+// the rest of the band moves left in hardware.
+template <class Transport>
+void ILI9341Driver<Transport>::scrollLine(const uint16_t *pixels) {
+    if (scroll_width == 0) return;
+    
+    // The column currently shown at the left becomes the rightmost one
+    // once the start address advances past it
+    uint16_t column = scroll_left + scroll_offset;
+    scroll_offset = (scroll_offset + 1) % scroll_width;
     
-    digitalWrite(TFT_CS, LOW);
+    // Window, column data and new start address in one transaction
+    bus.beginTransaction();
+    setAddressWindow(column, 0, column, ILI9341_HEIGHT - 1);
     writeCommand(ILI9341_MEMWRITE);
+    bus.writePixels(pixels, ILI9341_HEIGHT);
+    writeCommand(ILI9341_VSCRSADD);
+    writeData16(scroll_left + scroll_offset);
+    bus.endTransaction();
+    
+    // Keep the framebuffer copy in memory-column order
+    if (buffer.framebuffer && resolution == ILI9341_RES_FULL) {
+        for (uint16_t y = 0; y < ILI9341_HEIGHT; y++) {
+            buffer.framebuffer[y * ILI9341_WIDTH + column] = pixels[y];
+        }
+    }
+}
+
+// Native framebuffer value for a colour: the colour itself, or its index
+template <class Transport>
+uint16_t ILI9341Driver<Transport>::toPixel(uint16_t color) {
+    if (buffer.color_mode == ILI9341_COLOR_RGB565) {
+        return color;
+    }
+    return colorIndex(color);
+}
+
+// Store one native pixel; clipped
+template <class Transport>
+void ILI9341Driver<Transport>::writePixel(int16_t x, int16_t y, uint16_t pixel) {
+    if (x < clip_x0 || x > clip_x1 || y < clip_y0 || y > clip_y1) {
+        return;
+    }
     
-    uint32_t pixels = (uint32_t)w * h;
+    uint32_t offset = (uint32_t)y * buffer.width + x;
+    switch (buffer.color_mode) {
+        case ILI9341_COLOR_RGB565:
+            buffer.framebuffer[offset] = pixel;
+            break;
+        case ILI9341_COLOR_INDEXED8:
+            buffer.index_buffer[offset] = (uint8_t)pixel;
+            break;
+        case ILI9341_COLOR_INDEXED4: {
+            uint8_t &pair = buffer.index_buffer[offset >> 1];
+            pair = (x & 1) ? ((pair & 0xF0) | pixel) : ((pair & 0x0F) | (pixel << 4));
+            break;
+        }
+    }
+    markDirty(y, x, x);
+}
+
+// Store a horizontal run of one native pixel value; clipped
+template <class Transport>
+void ILI9341Driver<Transport>::writeSpan(int16_t x0, int16_t x1, int16_t y, uint16_t pixel) {
+    if (y < clip_y0 || y > clip_y1) return;
+    if (x0 < clip_x0) x0 = clip_x0;
+    if (x1 > clip_x1) x1 = clip_x1;
+    if (x0 > x1) return;
+    markDirty(y, x0, x1);
+    storeSpan(x0, x1, y, pixel);
+}
+
+// Fill a run that is already clipped, without marking it dirty
+template <class Transport>
+inline void ILI9341Driver<Transport>::storeSpan(int16_t x0, int16_t x1, int16_t y, uint16_t pixel) {
+    uint32_t row = (uint32_t)y * buffer.width;
+    switch (buffer.color_mode) {
+        case ILI9341_COLOR_RGB565: {
+            uint16_t *dst = &buffer.framebuffer[row + x0];
+            for (int16_t x = x0; x <= x1; x++) {
+                *dst++ = pixel;
+            }
+            break;
+        }
+        case ILI9341_COLOR_INDEXED8:
+            memset(&buffer.index_buffer[row + x0], pixel, x1 - x0 + 1);
+            break;
+        case ILI9341_COLOR_INDEXED4: {
+            // Odd leading and even trailing pixels share a byte with a neighbour
+            uint8_t *pairs = &buffer.index_buffer[row >> 1];
+            if (x0 & 1) {
+                pairs[x0 >> 1] = (pairs[x0 >> 1] & 0xF0) | pixel;
+                x0++;
+            }
+            if (x1 >= x0 && !(x1 & 1)) {
+                pairs[x1 >> 1] = (pairs[x1 >> 1] & 0x0F) | (pixel << 4);
+                x1--;
+            }
+            if (x0 < x1) {
+                memset(&buffer.index_buffer[(row + x0) >> 1], (pixel << 4) | pixel, (x1 - x0 + 1) >> 1);
+            }
+            break;
+        }
+    }
+}
+
+// Store a row of native pixels starting at (x, y); clipped
+template <class Transport>
+void ILI9341Driver<Transport>::writeRun(int16_t x, int16_t y, const uint16_t *pixels, uint16_t count) {
+    if (y < clip_y0 || y > clip_y1) return;
+    if (x < clip_x0) {
+        if (x + count <= clip_x0) return;
+        pixels += clip_x0 - x;
+        count -= clip_x0 - x;
+        x = clip_x0;
+    }
+    if (x > clip_x1) return;
+    if (x + count > clip_x1 + 1) count = clip_x1 + 1 - x;
     
-    while (pixels--) {
-        writeData16(color);
+    uint32_t offset = (uint32_t)y * buffer.width + x;
+    switch (buffer.color_mode) {
+        case ILI9341_COLOR_RGB565:
+            memcpy(&buffer.framebuffer[offset], pixels, count * sizeof(uint16_t));
+            break;
+        case ILI9341_COLOR_INDEXED8: {
+            uint8_t *dst = &buffer.index_buffer[offset];
+            for (uint16_t i = 0; i < count; i++) {
+                dst[i] = (uint8_t)pixels[i];
+            }
+            break;
+        }
+        case ILI9341_COLOR_INDEXED4:
+            for (uint16_t i = 0; i < count; i++) {
+                uint8_t &pair = buffer.index_buffer[(offset + i) >> 1];
+                pair = ((offset + i) & 1) ? ((pair & 0xF0) | pixels[i]) : ((pair & 0x0F) | (pixels[i] << 4));
+            }
+            break;
+    }
+    markDirty(y, x, x + count - 1);
+}
+
+// Grow a row's dirty span to cover columns x0 - x1
+template <class Transport>
+void ILI9341Driver<Transport>::markDirty(int16_t y, int16_t x0, int16_t x1) {
+    if (!buffer.dirty_lines[y]) {
+        buffer.dirty_lines[y] = 1;
+        buffer.dirty_x0[y] = x0;
+        buffer.dirty_x1[y] = x1;
+        return;
     }
+    if (x0 < buffer.dirty_x0[y]) buffer.dirty_x0[y] = x0;
+    if (x1 > buffer.dirty_x1[y]) buffer.dirty_x1[y] = x1;
+}
+
+// Mark every line for the next updateDisplay()
+template <class Transport>
+void ILI9341Driver<Transport>::markAllDirty() {
+    if (!buffer.dirty_lines) return;
     
-    digitalWrite(TFT_CS, HIGH);
+    for (uint16_t y = 0; y < ILI9341_HEIGHT; y++) {
+        buffer.dirty_lines[y] = 1;
+        buffer.dirty_x0[y] = 0;
+        buffer.dirty_x1[y] = ILI9341_WIDTH - 1;
+    }
 }
 
-// Draw a single pixel
-void ILI9341Display::drawPixel(uint16_t x, uint16_t y, uint16_t color) {
-    if ((x < 0) || (x >= ILI9341_WIDTH) || (y < 0) || (y >= ILI9341_HEIGHT)) {
+// Restrict drawing to a rectangle given in panel pixels
+template <class Transport>
+void ILI9341Driver<Transport>::setClipRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    clearClipRect();
+    if (w == 0 || h == 0) {
+        clip_x1 = -1;
         return;
     }
     
-    setAddressWindow(x, y, x, y);
+    int16_t x1 = ((int16_t)(x + w - 1)) >> buffer.shift_x;
+    int16_t y1 = ((int16_t)(y + h - 1)) >> buffer.shift_y;
+    clip_x0 = (int16_t)x >> buffer.shift_x;
+    clip_y0 = (int16_t)y >> buffer.shift_y;
+    if (x1 < clip_x1) clip_x1 = x1;
+    if (y1 < clip_y1) clip_y1 = y1;
+}
+
+// Allow drawing anywhere in the render target
+template <class Transport>
+void ILI9341Driver<Transport>::clearClipRect() {
+    clip_x0 = 0;
+    clip_y0 = 0;
+    clip_x1 = buffer.width - 1;
+    clip_y1 = buffer.height - 1;
+}
+
+// Select the render target size
+template <class Transport>
+bool ILI9341Driver<Transport>::setResolution(ILI9341Resolution res) {
+    uint8_t sx = (res == ILI9341_RES_FULL) ? 0 : 1;
+    uint8_t sy = (res == ILI9341_RES_HALF) ? 1 : 0;
+    uint32_t pixels = (uint32_t)(ILI9341_WIDTH >> sx) * (ILI9341_HEIGHT >> sy);
+    if (pixels > buffer.capacity) {
+        return false;
+    }
     
-    digitalWrite(TFT_CS, LOW);
-    writeCommand(ILI9341_MEMWRITE);
-    writeData16(color);
-    digitalWrite(TFT_CS, HIGH);
+    resolution = res;
+    buffer.shift_x = sx;
+    buffer.shift_y = sy;
+    buffer.width = ILI9341_WIDTH >> sx;
+    buffer.height = ILI9341_HEIGHT >> sy;
+    clearClipRect();
+    markAllDirty();
+    return true;
+}
+
+// Fill entire screen with a color
+template <class Transport>
+void ILI9341Driver<Transport>::fillScreen(uint16_t color) {
+    fillRect(0, 0, ILI9341_WIDTH, ILI9341_HEIGHT, color);
+}
+
+// Fill a rectangle with a color. Coordinates are taken as signed so
+// shapes hanging off the left or top edge are clipped, not wrapped.
+template <class Transport>
+void ILI9341Driver<Transport>::fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    if (!hasFramebuffer() || w == 0 || h == 0) return;
+    
+    // Panel coordinates to render coordinates; the arithmetic shift keeps
+    // negative values negative
+    int16_t x0 = (int16_t)x >> buffer.shift_x;
+    int16_t y0 = (int16_t)y >> buffer.shift_y;
+    int16_t x1 = ((int16_t)x + (int16_t)w - 1) >> buffer.shift_x;
+    int16_t y1 = ((int16_t)y + (int16_t)h - 1) >> buffer.shift_y;
+    if (y0 < 0) y0 = 0;
+    if (y1 >= (int16_t)buffer.height) y1 = buffer.height - 1;
+    
+    uint16_t pixel = toPixel(color);
+    for (int16_t py = y0; py <= y1; py++) {
+        writeSpan(x0, x1, py, pixel);
+    }
+}
+
+// Draw a single pixel
+template <class Transport>
+void ILI9341Driver<Transport>::drawPixel(uint16_t x, uint16_t y, uint16_t color) {
+    if (!hasFramebuffer()) return;
+    
+    writePixel((int16_t)x >> buffer.shift_x, (int16_t)y >> buffer.shift_y, toPixel(color));
 }
 
 // Draw a line using Bresenham's algorithm
-void ILI9341Display::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+template <class Transport>
+void ILI9341Driver<Transport>::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (!hasFramebuffer()) return;
+    
+    uint16_t pixel = toPixel(color);
+    x0 >>= buffer.shift_x;
+    x1 >>= buffer.shift_x;
+    y0 >>= buffer.shift_y;
+    y1 >>= buffer.shift_y;
+    
+    // Always step downwards, so drawLines() produces the same pixels
+    if (y0 > y1) {
+        int16_t t = x0;
+        x0 = x1;
+        x1 = t;
+        t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+    
     int16_t dx = abs(x1 - x0);
     int16_t dy = abs(y1 - y0);
     int16_t sx = (x0 < x1) ? 1 : -1;
@@ -245,7 +683,7 @@ void ILI9341Display::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, ui
     int16_t err = dx - dy;
     
     while (true) {
-        drawPixel(x0, y0, color);
+        writePixel(x0, y0, pixel);
         
         if ((x0 == x1) && (y0 == y1)) {
             break;
@@ -263,8 +701,299 @@ void ILI9341Display::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, ui
     }
 }
 
+// Advance a line through its current row. Returns the row's column range
+// in xa - xb, and false once the line has ended on this row.
+template <class Transport>
+inline bool ILI9341Driver<Transport>::edgeRow(ILI9341EdgeState &e, int16_t &xa, int16_t &xb) {
+    // Work on locals; the table may alias framebuffer writes
+    int16_t x = e.x;
+    int32_t err = e.err;
+    const int32_t dx = e.dx;
+    const int32_t dy = e.dy;
+    const int16_t sx = e.sx;
+    const int16_t last_x = e.x1;
+    const bool last_row = e.y == e.y1;
+    int16_t lo = x;
+    int16_t hi = x;
+    
+    // The same steps as drawLine(); a y step ends the row
+    while (!last_row || x != last_x) {
+        int32_t e2 = 2 * err;
+        bool step_y = e2 < dx;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (step_y) {
+            err += dx;
+            e.y++;
+            e.x = x;
+            e.err = err;
+            xa = lo;
+            xb = hi;
+            return true;
+        }
+        if (x < lo) lo = x;
+        if (x > hi) hi = x;
+    }
+    
+    e.x = x;
+    e.err = err;
+    xa = lo;
+    xb = hi;
+    return false;
+}
+
+// Draw a batch of lines. Lines are bucketed by their first visible row;
+// the sweep then walks the rows top to bottom, adds the lines starting on
+// each row to the active list, and writes one span per active line, so
+// every framebuffer row is visited once.
+template <class Transport>
+void ILI9341Driver<Transport>::drawLines(const ILI9341Segment *segments, uint16_t count) {
+    if (!hasFramebuffer()) return;
+    
+    while (count > ILI9341_LINE_BATCH) {
+        drawLines(segments, ILI9341_LINE_BATCH);
+        segments += ILI9341_LINE_BATCH;
+        count -= ILI9341_LINE_BATCH;
+    }
+    
+    uint8_t sx = buffer.shift_x;
+    uint8_t sy = buffer.shift_y;
+    int16_t first_row = clip_y1 + 1;
+    int16_t last_row = -1;
+    int16_t used = 0;
+    for (int16_t y = clip_y0; y <= clip_y1; y++) {
+        edge_bucket[y] = -1;
+    }
+    
+    // Set up the lines that reach the clip rows
+    for (uint16_t i = 0; i < count; i++) {
+        const ILI9341Segment &seg = segments[i];
+        int16_t x0 = seg.x0 >> sx;
+        int16_t y0 = seg.y0 >> sy;
+        int16_t x1 = seg.x1 >> sx;
+        int16_t y1 = seg.y1 >> sy;
+        if (y0 > y1) {
+            int16_t t = x0;
+            x0 = x1;
+            x1 = t;
+            t = y0;
+            y0 = y1;
+            y1 = t;
+        }
+        if (y1 < clip_y0 || y0 > clip_y1) continue;
+        
+        ILI9341EdgeState &e = edge_table[used];
+        e.x = x0;
+        e.y = y0;
+        e.x1 = x1;
+        e.y1 = y1;
+        e.dx = abs(x1 - x0);
+        e.dy = y1 - y0;
+        e.sx = (x0 < x1) ? 1 : -1;
+        e.err = (int32_t)e.dx - e.dy;
+        e.pixel = toPixel(seg.color);
+        
+        // Step lines that start above the clip down to its first row
+        int16_t xa;
+        int16_t xb;
+        while (e.y < clip_y0) {
+            edgeRow(e, xa, xb);
+        }
+        
+        e.next = edge_bucket[e.y];
+        edge_bucket[e.y] = used++;
+        if (e.y < first_row) first_row = e.y;
+        if (y1 > last_row) last_row = y1;
+    }
+    if (last_row > clip_y1) last_row = clip_y1;
+    
+    // The active list is kept in batch order so that where lines cross,
+    // the later one wins, as with sequential drawLine() calls
+    int16_t active = -1;
+    for (int16_t y = first_row; y <= last_row; y++) {
+        for (int16_t i = edge_bucket[y]; i >= 0;) {
+            int16_t next = edge_table[i].next;
+            int16_t *link = &active;
+            while (*link >= 0 && *link < i) {
+                link = &edge_table[*link].next;
+            }
+            edge_table[i].next = *link;
+            *link = i;
+            i = next;
+        }
+        
+        // Rows in the sweep are inside the clip rows; only columns are
+        // clipped per span, and the row is marked dirty once
+        int16_t row_lo = clip_x1 + 1;
+        int16_t row_hi = -1;
+        int16_t *link = &active;
+        while (*link >= 0) {
+            ILI9341EdgeState &e = edge_table[*link];
+            int16_t xa;
+            int16_t xb;
+            bool more = edgeRow(e, xa, xb);
+            if (xa < clip_x0) xa = clip_x0;
+            if (xb > clip_x1) xb = clip_x1;
+            if (xa <= xb) {
+                storeSpan(xa, xb, y, e.pixel);
+                if (xa < row_lo) row_lo = xa;
+                if (xb > row_hi) row_hi = xb;
+            }
+            if (more) {
+                link = &e.next;
+            } else {
+                *link = e.next;
+            }
+        }
+        if (row_hi >= 0) {
+            markDirty(y, row_lo, row_hi);
+        }
+    }
+}
+
+// Fade the lit part of each row inside the clip. Only the pixels that
+// were not yet black are decayed and marked dirty; once a row has faded
+// out it costs nothing until something is drawn on it again.
+template <class Transport>
+void ILI9341Driver<Transport>::fadeScreen(uint8_t keep) {
+    if (!buffer.framebuffer || buffer.color_mode != ILI9341_COLOR_RGB565) return;
+    
+    uint8_t k = keep >> 3;
+    for (int16_t y = clip_y0; y <= clip_y1; y++) {
+        int16_t lit0 = buffer.lit_x0[y];
+        int16_t lit1 = buffer.lit_x1[y];
+        int16_t x0 = (lit0 > clip_x0) ? lit0 : clip_x0;
+        int16_t x1 = (lit1 < clip_x1) ? lit1 : clip_x1;
+        if (x0 > x1) continue;
+        
+        // Trim black pixels off both ends before decaying
+        uint16_t *row = &buffer.framebuffer[(uint32_t)y * buffer.width];
+        int16_t lo = x0;
+        int16_t hi = x1;
+        while (lo <= hi && row[lo] == 0) lo++;
+        while (hi >= lo && row[hi] == 0) hi--;
+        
+        // The lit span can only shrink where the clip did not cut it
+        if (x0 == lit0) buffer.lit_x0[y] = lo;
+        if (x1 == lit1) buffer.lit_x1[y] = hi;
+        if (lo > hi) {
+            if (x0 == lit0 && x1 == lit1) {
+                buffer.lit_x0[y] = 1;
+                buffer.lit_x1[y] = 0;
+            }
+            continue;
+        }
+        
+        ili9341DecayRun(&row[lo], k, hi - lo + 1);
+        markDirty(y, lo, hi);
+    }
+}
+
+// Blend an RGB565 colour into the framebuffer; clipped
+template <class Transport>
+inline void ILI9341Driver<Transport>::blendPixel(int16_t x, int16_t y, uint16_t color, uint8_t alpha) {
+    if (x < clip_x0 || x > clip_x1 || y < clip_y0 || y > clip_y1 || alpha == 0) {
+        return;
+    }
+    
+    uint16_t &dst = buffer.framebuffer[(uint32_t)y * buffer.width + x];
+    dst = ili9341Blend(color, dst, alpha);
+    markDirty(y, x, x);
+}
+
+// Draw an anti-aliased line with Wu's algorithm. Endpoints are converted
+// to 16.16 render coordinates, so reduced resolutions keep the sub-pixel
+// position of the panel coordinates. Each step along the major axis
+// splits one pixel of coverage between the two pixels straddling the line.
+template <class Transport>
+void ILI9341Driver<Transport>::drawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (!hasFramebuffer()) return;
+    if (buffer.color_mode != ILI9341_COLOR_RGB565) {
+        drawLine(x0, y0, x1, y1, color);
+        return;
+    }
+    
+    // Set-up in 64 bits; differences of 16.16 coordinates can exceed 32
+    int64_t fx0 = ((int64_t)x0 * 65536) >> buffer.shift_x;
+    int64_t fy0 = ((int64_t)y0 * 65536) >> buffer.shift_y;
+    int64_t fx1 = ((int64_t)x1 * 65536) >> buffer.shift_x;
+    int64_t fy1 = ((int64_t)y1 * 65536) >> buffer.shift_y;
+    
+    // Walk the major axis as 'u' and the minor one as 'v'
+    bool steep = llabs(fy1 - fy0) > llabs(fx1 - fx0);
+    int64_t u0 = steep ? fy0 : fx0;
+    int64_t v0 = steep ? fx0 : fy0;
+    int64_t u1 = steep ? fy1 : fx1;
+    int64_t v1 = steep ? fx1 : fy1;
+    if (u0 > u1) {
+        int64_t t = u0;
+        u0 = u1;
+        u1 = t;
+        t = v0;
+        v0 = v1;
+        v1 = t;
+    }
+    
+    // Pixel centres sit on integer coordinates
+    int16_t first = (u0 + 0x8000) >> 16;
+    int16_t last = (u1 + 0x8000) >> 16;
+    int32_t gradient = 0;
+    if (u1 != u0) {
+        gradient = (int32_t)((v1 - v0) * 65536 / (u1 - u0));
+    }
+    
+    // Only the clipped part of the major axis is walked
+    int16_t lo = steep ? clip_y0 : clip_x0;
+    int16_t hi = steep ? clip_y1 : clip_x1;
+    if (first < lo) first = lo;
+    if (last > hi) last = hi;
+    if (first > last) return;
+    
+    // The minor coordinate stays between the endpoints, so the walk
+    // itself fits 16.16
+    int32_t v = (int32_t)(v0 + ((gradient * ((int64_t)first * 65536 - u0)) >> 16));
+    uint16_t *fb = buffer.framebuffer;
+    uint16_t width = buffer.width;
+    if (steep) {
+        // Both pixels of a step share a row: one dirty mark per row
+        for (int16_t u = first; u <= last; u++) {
+            int16_t vi = v >> 16;
+            uint8_t frac = (v >> 8) & 0xFF;
+            v += gradient;
+            if (vi >= clip_x0 && vi < clip_x1) {
+                uint16_t *dst = &fb[(uint32_t)u * width + vi];
+                dst[0] = ili9341Blend(color, dst[0], 255 - frac);
+                dst[1] = ili9341Blend(color, dst[1], frac);
+                markDirty(u, vi, vi + 1);
+            } else {
+                blendPixel(vi, u, color, 255 - frac);
+                blendPixel(vi + 1, u, color, frac);
+            }
+        }
+        return;
+    }
+    for (int16_t u = first; u <= last; u++) {
+        int16_t vi = v >> 16;
+        uint8_t frac = (v >> 8) & 0xFF;
+        v += gradient;
+        if (vi >= clip_y0 && vi < clip_y1) {
+            uint16_t *dst = &fb[(uint32_t)vi * width + u];
+            dst[0] = ili9341Blend(color, dst[0], 255 - frac);
+            dst[width] = ili9341Blend(color, dst[width], frac);
+            markDirty(vi, u, u);
+            markDirty(vi + 1, u, u);
+        } else {
+            blendPixel(u, vi, color, 255 - frac);
+            blendPixel(u, vi + 1, color, frac);
+        }
+    }
+}
+
 // Draw a rectangle outline
-void ILI9341Display::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+template <class Transport>
+void ILI9341Driver<Transport>::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
     drawLine(x, y, x + w - 1, y, color);
     drawLine(x + w - 1, y, x + w - 1, y + h - 1, color);
     drawLine(x, y + h - 1, x + w - 1, y + h - 1, color);
@@ -272,20 +1001,28 @@ void ILI9341Display::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, ui
 }
 
 // Draw a circle using Midpoint Circle Algorithm
-void ILI9341Display::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+template <class Transport>
+void ILI9341Driver<Transport>::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    if (!hasFramebuffer()) return;
+    
+    uint16_t pixel = toPixel(color);
+    uint8_t sx = buffer.shift_x;
+    uint8_t sy = buffer.shift_y;
     int16_t x = 0;
     int16_t y = r;
     int16_t dp = 1 - r;
     
+    // Points are traced at panel resolution and mapped down, so the shape
+    // stays round when only one axis is halved
     while (x <= y) {
-        drawPixel(x0 + x, y0 + y, color);
-        drawPixel(x0 - x, y0 + y, color);
-        drawPixel(x0 + x, y0 - y, color);
-        drawPixel(x0 - x, y0 - y, color);
-        drawPixel(x0 + y, y0 + x, color);
-        drawPixel(x0 - y, y0 + x, color);
-        drawPixel(x0 + y, y0 - x, color);
-        drawPixel(x0 - y, y0 - x, color);
+        writePixel((x0 + x) >> sx, (y0 + y) >> sy, pixel);
+        writePixel((x0 - x) >> sx, (y0 + y) >> sy, pixel);
+        writePixel((x0 + x) >> sx, (y0 - y) >> sy, pixel);
+        writePixel((x0 - x) >> sx, (y0 - y) >> sy, pixel);
+        writePixel((x0 + y) >> sx, (y0 + x) >> sy, pixel);
+        writePixel((x0 - y) >> sx, (y0 + x) >> sy, pixel);
+        writePixel((x0 + y) >> sx, (y0 - x) >> sy, pixel);
+        writePixel((x0 - y) >> sx, (y0 - x) >> sy, pixel);
         
         if (dp < 0) {
             dp = dp + 2 * x + 3;
@@ -298,78 +1035,566 @@ void ILI9341Display::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t colo
 }
 
 // Draw a triangle
-void ILI9341Display::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+template <class Transport>
+void ILI9341Driver<Transport>::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
     drawLine(x0, y0, x1, y1, color);
     drawLine(x1, y1, x2, y2, color);
     drawLine(x2, y2, x0, y0, color);
 }
 
-// Draw a character (simplified 5x7 ASCII)
-void ILI9341Display::drawChar(uint16_t x, uint16_t y, char c, uint16_t color, uint16_t bg, uint8_t size) {
-    // Simplified character drawing - just draw a filled rectangle for now
-    // Full font implementation would require font data arrays
-    fillRect(x, y, 5 * size, 7 * size, bg);
-    drawRect(x, y, 5 * size, 7 * size, color);
+// Blit a sprite. Full-resolution RGB565 copies each opaque run of a row
+// with one memcpy and blends the edge pixels; other targets sample the
+// sprite per render pixel.
+template <class Transport>
+void ILI9341Driver<Transport>::drawSprite(int16_t x, int16_t y, const ILI9341Sprite &sprite) {
+    if (!hasFramebuffer() || sprite.width == 0 || sprite.height == 0) return;
+    
+    uint8_t sx = buffer.shift_x;
+    uint8_t sy = buffer.shift_y;
+    int16_t x0 = x >> sx;
+    int16_t y0 = y >> sy;
+    int16_t x1 = (x + (int16_t)sprite.width - 1) >> sx;
+    int16_t y1 = (y + (int16_t)sprite.height - 1) >> sy;
+    if (x0 < clip_x0) x0 = clip_x0;
+    if (y0 < clip_y0) y0 = clip_y0;
+    if (x1 > clip_x1) x1 = clip_x1;
+    if (y1 > clip_y1) y1 = clip_y1;
+    if (x0 > x1 || y0 > y1) return;
+    
+    if (buffer.color_mode == ILI9341_COLOR_RGB565 && sx == 0 && sy == 0) {
+        for (int16_t py = y0; py <= y1; py++) {
+            // 'px' walks sprite columns; the framebuffer column is x + px
+            uint32_t row = (uint32_t)(py - y) * sprite.width;
+            const uint16_t *src = &sprite.pixels[row];
+            uint16_t *dst = &buffer.framebuffer[(uint32_t)py * buffer.width];
+            int16_t c0 = x0 - x;
+            int16_t c1 = x1 - x;
+            if (!sprite.mask) {
+                memcpy(&dst[x0], &src[c0], (c1 - c0 + 1) * sizeof(uint16_t));
+                markDirty(py, x0, x1);
+                continue;
+            }
+            
+            const uint8_t *cov = &sprite.mask[row];
+            int16_t first = -1;
+            int16_t last = -1;
+            int16_t px = c0;
+            while (px <= c1) {
+                uint8_t a = cov[px];
+                if (a == 255) {
+                    int16_t run = px;
+                    while (px <= c1 && cov[px] == 255) px++;
+                    memcpy(&dst[x + run], &src[run], (px - run) * sizeof(uint16_t));
+                    if (first < 0) first = run;
+                    last = px - 1;
+                    continue;
+                }
+                if (a) {
+                    // Edge pixels come in runs along the slope of the rim
+                    int16_t run = px;
+                    while (px <= c1 && cov[px] != 0 && cov[px] != 255) px++;
+                    ili9341BlendRun(&dst[x + run], &src[run], &cov[run], px - run);
+                    if (first < 0) first = run;
+                    last = px - 1;
+                    continue;
+                }
+                px++;
+            }
+            if (first >= 0) markDirty(py, first + x, last + x);
+        }
+        return;
+    }
+    
+    // Reduced targets: each render pixel takes the most covered sprite
+    // pixel of the panel pixels it stands for, so thin outlines survive
+    // the same way they do for the line and circle rasterizers
+    for (int16_t ry = y0; ry <= y1; ry++) {
+        int16_t row0 = (ry << sy) - y;
+        int16_t row1 = row0 + (1 << sy) - 1;
+        if (row0 < 0) row0 = 0;
+        if (row1 >= (int16_t)sprite.height) row1 = sprite.height - 1;
+        
+        for (int16_t rx = x0; rx <= x1; rx++) {
+            int16_t col0 = (rx << sx) - x;
+            int16_t col1 = col0 + (1 << sx) - 1;
+            if (col0 < 0) col0 = 0;
+            if (col1 >= (int16_t)sprite.width) col1 = sprite.width - 1;
+            
+            uint32_t best = (uint32_t)row0 * sprite.width + col0;
+            uint8_t a = 255;
+            if (sprite.mask) {
+                a = 0;
+                for (int16_t row = row0; row <= row1; row++) {
+                    for (int16_t col = col0; col <= col1; col++) {
+                        uint32_t i = (uint32_t)row * sprite.width + col;
+                        if (sprite.mask[i] > a) {
+                            a = sprite.mask[i];
+                            best = i;
+                        }
+                    }
+                }
+            }
+            
+            if (buffer.color_mode == ILI9341_COLOR_RGB565) {
+                if (a == 0) continue;
+                uint16_t dst = buffer.framebuffer[(uint32_t)ry * buffer.width + rx];
+                writePixel(rx, ry, (a == 255) ? sprite.pixels[best] : ili9341Blend(sprite.pixels[best], dst, a));
+            } else if (a >= 128) {
+                writePixel(rx, ry, toPixel(sprite.pixels[best]));
+            }
+        }
+    }
+}
+
+// Select the font used by the text functions
+template <class Transport>
+bool ILI9341Driver<Transport>::setFont(const ILI9341Font *f) {
+    if (!f || f->height > 8 || f->width > f->advance || f->height > f->line_height) {
+        return false;
+    }
+    if ((uint16_t)f->advance * f->line_height > ILI9341_GLYPH_MAX_PIXELS) {
+        return false;
+    }
+    
+    font = f;
+    return true;
 }
 
-// Draw a string
-void ILI9341Display::drawString(uint16_t x, uint16_t y, const char *str, uint16_t color, uint16_t bg, uint8_t size) {
-    uint16_t pos_x = x;
+// Expanded cell for a character, built from the packed font on a miss.
+// The search probes onward from the hashed slot and a miss fills the
+// empty slot that ends it. Only a full cache evicts: the first slot on
+// the path that is not in 'claimed', which holds cells the current
+// string still points to.
+template <class Transport>
+const uint16_t* ILI9341Driver<Transport>::glyphCell(uint8_t c, uint16_t fg, uint16_t bg, uint64_t &claimed) {
+    uint8_t home = (c ^ (fg * 7) ^ (bg * 13)) & (ILI9341_GLYPH_CACHE - 1);
+    int16_t evict = -1;
+    int16_t victim = -1;
     
-    while (*str) {
-        drawChar(pos_x, y, *str, color, bg, size);
-        pos_x += 6 * size;
-        str++;
+    for (uint8_t probe = 0; probe < ILI9341_GLYPH_CACHE; probe++) {
+        uint8_t slot = (home + probe) & (ILI9341_GLYPH_CACHE - 1);
+        ILI9341Glyph &g = glyph_cache[slot];
+        if (!g.font) {
+            victim = slot;
+            break;
+        }
+        if (g.font == font && g.c == c && g.fg == fg && g.bg == bg) {
+            claimed |= (uint64_t)1 << slot;
+            return g.pixels;
+        }
+        if (evict < 0 && !(claimed & ((uint64_t)1 << slot))) {
+            evict = slot;
+        }
+    }
+    if (victim < 0) {
+        victim = evict;
     }
+    
+    ILI9341Glyph &g = glyph_cache[victim];
+    claimed |= (uint64_t)1 << victim;
+    
+    // Characters the font lacks are shown as '?'
+    uint8_t glyph = c;
+    if (glyph < font->first || glyph > font->last) {
+        glyph = ('?' >= font->first && '?' <= font->last) ? '?' : font->first;
+    }
+    
+    const uint8_t *columns = &font->data[(glyph - font->first) * font->width];
+    uint8_t cw = font->advance;
+    for (uint8_t col = 0; col < cw; col++) {
+        uint8_t bits = (col < font->width) ? columns[col] : 0;
+        for (uint8_t row = 0; row < font->line_height; row++) {
+            g.pixels[row * cw + col] = ((bits >> row) & 1) ? fg : bg;
+        }
+    }
+    
+    g.font = font;
+    g.c = c;
+    g.fg = fg;
+    g.bg = bg;
+    return g.pixels;
 }
 
-// Update the entire display from framebuffer
-void ILI9341Display::updateDisplay() {
-    updateRect(0, 0, ILI9341_WIDTH, ILI9341_HEIGHT);
+// Look up the cells of every character that starts on the panel
+template <class Transport>
+uint16_t ILI9341Driver<Transport>::gatherCells(uint16_t x, const char *str, uint16_t fg, uint16_t bg, uint8_t size, const uint16_t **cells) {
+    uint16_t step = font->advance * size;
+    uint16_t count = 0;
+    uint64_t claimed = 0;
+    
+    while (*str && count < ILI9341_TEXT_MAX_CHARS && x + count * step < ILI9341_WIDTH) {
+        cells[count++] = glyphCell((uint8_t)*str++, fg, bg, claimed);
+    }
+    return count;
 }
 
-// Update a rectangular region of the display
-void ILI9341Display::updateRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
-    if (!buffer.is_initialized || !buffer.framebuffer) {
+// Assemble one output row of a string: row 'cell_row' of each cell,
+// every pixel repeated 'size' times
+template <class Transport>
+void ILI9341Driver<Transport>::expandTextRow(const uint16_t **cells, uint16_t count, uint8_t cell_row, uint8_t size, uint16_t *out, uint16_t width) {
+    uint8_t cw = font->advance;
+    uint16_t n = 0;
+    
+    for (uint16_t i = 0; i < count && n < width; i++) {
+        const uint16_t *src = cells[i] + cell_row * cw;
+        if (size == 1) {
+            uint16_t k = (width - n < cw) ? width - n : cw;
+            memcpy(&out[n], src, k * sizeof(uint16_t));
+            n += k;
+            continue;
+        }
+        for (uint8_t col = 0; col < cw && n < width; col++) {
+            for (uint8_t s = 0; s < size && n < width; s++) {
+                out[n++] = src[col];
+            }
+        }
+    }
+}
+
+// Draw a character
+template <class Transport>
+void ILI9341Driver<Transport>::drawChar(uint16_t x, uint16_t y, char c, uint16_t color, uint16_t bg, uint8_t size) {
+    char str[2] = { c, 0 };
+    drawString(x, y, str, color, bg, size);
+}
+
+// Draw a string into the framebuffer, one row span per output row
+template <class Transport>
+void ILI9341Driver<Transport>::drawString(uint16_t x, uint16_t y, const char *str, uint16_t color, uint16_t bg, uint8_t size) {
+    if (!hasFramebuffer()) {
+        drawStringDirect(x, y, str, color, bg, size);
         return;
     }
+    if (size == 0 || x >= ILI9341_WIDTH || y >= ILI9341_HEIGHT) return;
+    
+    const uint16_t *cells[ILI9341_TEXT_MAX_CHARS];
+    uint16_t count = gatherCells(x, str, toPixel(color), toPixel(bg), size, cells);
+    if (count == 0) return;
+    
+    uint16_t w = count * font->advance * size;
+    uint16_t h = font->line_height * size;
+    if (x + w > ILI9341_WIDTH) w = ILI9341_WIDTH - x;
+    if (y + h > ILI9341_HEIGHT) h = ILI9341_HEIGHT - y;
     
+    // In reduced modes only the first panel row and column landing on each
+    // render pixel are kept
+    uint8_t sx = buffer.shift_x;
+    uint8_t sy = buffer.shift_y;
+    int16_t last_row = -1;
+    
+    for (uint16_t row = 0; row < h; row++) {
+        int16_t ry = (y + row) >> sy;
+        if (ry == last_row) continue;
+        last_row = ry;
+        
+        expandTextRow(cells, count, row / size, size, line_buffer, w);
+        
+        uint16_t n = w;
+        if (sx) {
+            n = 0;
+            for (uint16_t i = 0; i < w; i++) {
+                if (i == 0 || !((x + i) & 1)) {
+                    line_buffer[n++] = line_buffer[i];
+                }
+            }
+        }
+        writeRun(x >> sx, ry, line_buffer, n);
+    }
+}
+
+// Send a string straight to the panel in one address window, bypassing
+// the framebuffer
+template <class Transport>
+void ILI9341Driver<Transport>::drawStringDirect(uint16_t x, uint16_t y, const char *str, uint16_t color, uint16_t bg, uint8_t size) {
+    if (!buffer.is_initialized || size == 0 || x >= ILI9341_WIDTH || y >= ILI9341_HEIGHT) return;
+    
+    const uint16_t *cells[ILI9341_TEXT_MAX_CHARS];
+    uint16_t count = gatherCells(x, str, color, bg, size, cells);
+    if (count == 0) return;
+    
+    uint16_t w = count * font->advance * size;
+    uint16_t h = font->line_height * size;
+    if (x + w > ILI9341_WIDTH) w = ILI9341_WIDTH - x;
+    if (y + h > ILI9341_HEIGHT) h = ILI9341_HEIGHT - y;
+    
+    bus.beginTransaction();
     setAddressWindow(x, y, x + w - 1, y + h - 1);
+    writeCommand(ILI9341_MEMWRITE);
+    for (uint16_t row = 0; row < h; row++) {
+        expandTextRow(cells, count, row / size, size, line_buffer, w);
+        bus.writePixels(line_buffer, w);
+    }
+    bus.endTransaction();
+}
+
+// Send the dirty spans of dirty lines, clipped to columns c0 - c1
+template <class Transport>
+void ILI9341Driver<Transport>::flushColumns(uint16_t c0, uint16_t c1) {
+    uint8_t sx = buffer.shift_x;
+    uint8_t sy = buffer.shift_y;
+    int16_t run_start = -1;
+    uint16_t run_x0 = 0;
+    uint16_t run_x1 = 0;
     
-    digitalWrite(TFT_CS, LOW);
+    // Coalesce consecutive dirty panel rows with the same column span into
+    // one address window. A render row covers 1 << shift_y panel rows.
+    for (uint16_t y = 0; y <= ILI9341_HEIGHT; y++) {
+        bool send = y < ILI9341_HEIGHT && buffer.dirty_lines[y >> sy];
+        uint16_t x0 = 0;
+        uint16_t x1 = 0;
+        if (send) {
+            x0 = buffer.dirty_x0[y >> sy] << sx;
+            x1 = ((buffer.dirty_x1[y >> sy] + 1) << sx) - 1;
+            if (x0 < c0) x0 = c0;
+            if (x1 > c1) x1 = c1;
+            send = x0 <= x1;
+        }
+        
+        if (run_start >= 0 && (!send || x0 != run_x0 || x1 != run_x1)) {
+            updateRect(run_x0, run_start, run_x1 - run_x0 + 1, y - run_start);
+            run_start = -1;
+        }
+        if (send && run_start < 0) {
+            run_start = y;
+            run_x0 = x0;
+            run_x1 = x1;
+        }
+    }
+}
+
+// Send dirty lines from the framebuffer. In partial mode only the driven
+// columns are sent, and a scroll area is left to scrollLine().
+template <class Transport>
+void ILI9341Driver<Transport>::updateDisplay() {
+    if (!buffer.is_initialized || !buffer.dirty_lines) {
+        return;
+    }
+    
+    // Driven columns, less the scroll band, in at most two pieces
+    uint16_t first = partial_first;
+    uint16_t last = (partial_last < ILI9341_WIDTH) ? partial_last : ILI9341_WIDTH - 1;
+    uint16_t scroll_end = scroll_left + scroll_width;
+    if (scroll_width == 0 || scroll_end <= first || scroll_left > last) {
+        flushColumns(first, last);
+    } else {
+        if (scroll_left > first) flushColumns(first, scroll_left - 1);
+        if (scroll_end <= last) flushColumns(scroll_end, last);
+    }
+    
+    // What was sent may now be lit; fadeScreen() narrows it again. A span
+    // reaching outside the driven columns stays dirty for exitPartialMode().
+    uint8_t sx = buffer.shift_x;
+    uint8_t sy = buffer.shift_y;
+    for (uint16_t y = 0; y <= ((ILI9341_HEIGHT - 1) >> sy); y++) {
+        if (!buffer.dirty_lines[y]) continue;
+        
+        uint16_t x0 = buffer.dirty_x0[y];
+        uint16_t x1 = buffer.dirty_x1[y];
+        if (x1 >= buffer.width) x1 = buffer.width - 1;
+        if (partial_mode && ((x0 << sx) < first || (((x1 + 1) << sx) - 1) > last)) continue;
+        if (buffer.lit_x0[y] > buffer.lit_x1[y]) {
+            buffer.lit_x0[y] = x0;
+            buffer.lit_x1[y] = x1;
+        } else {
+            if (x0 < buffer.lit_x0[y]) buffer.lit_x0[y] = x0;
+            if (x1 > buffer.lit_x1[y]) buffer.lit_x1[y] = x1;
+        }
+        buffer.dirty_lines[y] = 0;
+    }
+}
+
+// Update a rectangular region of the display. Indexed pixels are expanded
+// through the palette one line at a time. If another device asks for the
+// bus, it gets it between two rows and the rest follows in a new window.
+template <class Transport>
+void ILI9341Driver<Transport>::updateRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    if (!buffer.is_initialized || !hasFramebuffer()) {
+        return;
+    }
+    if (x >= ILI9341_WIDTH || y >= ILI9341_HEIGHT || w == 0 || h == 0) {
+        return;
+    }
+    if (x + w > ILI9341_WIDTH) w = ILI9341_WIDTH - x;
+    if (y + h > ILI9341_HEIGHT) h = ILI9341_HEIGHT - y;
+    
+    bus.beginTransaction();
+    setAddressWindow(x, y, x + w - 1, y + h - 1);
     writeCommand(ILI9341_MEMWRITE);
     
+    uint8_t sx = buffer.shift_x;
+    uint8_t sy = buffer.shift_y;
+    int16_t expanded_row = -1;
+    
     for (uint16_t py = y; py < y + h; py++) {
-        for (uint16_t px = x; px < x + w; px++) {
-            uint16_t pixel = buffer.framebuffer[py * ILI9341_WIDTH + px];
-            writeData16(pixel);
+        if (ili9341_bus_wanted && py > y) {
+            bus.endTransaction();
+            ili9341_grantBus();
+            bus.beginTransaction();
+            setAddressWindow(x, py, x + w - 1, y + h - 1);
+            writeCommand(ILI9341_MEMWRITE);
         }
+        
+        const uint16_t *src = line_buffer;
+        uint16_t render_row = py >> sy;
+        uint32_t row = (uint32_t)render_row * buffer.width;
+        
+        // Duplicated lines reuse the line already expanded
+        if (buffer.color_mode == ILI9341_COLOR_RGB565 && sx == 0) {
+            src = &buffer.framebuffer[row + x];
+        } else if (render_row != expanded_row) {
+            expanded_row = render_row;
+            switch (buffer.color_mode) {
+                case ILI9341_COLOR_RGB565: {
+                    const uint16_t *pix = &buffer.framebuffer[row];
+                    for (uint16_t i = 0; i < w; i++) {
+                        line_buffer[i] = pix[(x + i) >> sx];
+                    }
+                    break;
+                }
+                case ILI9341_COLOR_INDEXED8: {
+                    const uint8_t *idx = &buffer.index_buffer[row];
+                    for (uint16_t i = 0; i < w; i++) {
+                        line_buffer[i] = palette[idx[(x + i) >> sx]];
+                    }
+                    break;
+                }
+                case ILI9341_COLOR_INDEXED4:
+                    for (uint16_t i = 0; i < w; i++) {
+                        uint32_t offset = row + ((x + i) >> sx);
+                        uint8_t pair = buffer.index_buffer[offset >> 1];
+                        line_buffer[i] = palette[(offset & 1) ? (pair & 0x0F) : (pair >> 4)];
+                    }
+                    break;
+            }
+        }
+        
+        bus.writePixels(src, w);
     }
     
-    digitalWrite(TFT_CS, HIGH);
+    bus.endTransaction();
+}
+
+// Define a palette entry; drawing with 'color' will use this index
+template <class Transport>
+void ILI9341Driver<Transport>::setPaletteEntry(uint8_t index, uint16_t color) {
+    if (index >= palette_limit) return;
+    
+    palette_key[index] = color;
+    palette[index] = color;
+    if (index >= palette_used) {
+        palette_used = index + 1;
+    }
+    cache_valid = 0;
+    markAllDirty();
+}
+
+// Change what an entry is displayed as, without changing its key colour
+template <class Transport>
+void ILI9341Driver<Transport>::remapPaletteEntry(uint8_t index, uint16_t color) {
+    if (index >= palette_used) return;
+    
+    palette[index] = color;
+    markAllDirty();
+}
+
+// Scale every entry towards black
+template <class Transport>
+void ILI9341Driver<Transport>::fadePalette(uint8_t level) {
+    for (uint16_t i = 0; i < palette_used; i++) {
+        uint16_t c = palette_key[i];
+        uint16_t r = (c >> 11) * level / 255;
+        uint16_t g = ((c >> 5) & 0x3F) * level / 255;
+        uint16_t b = (c & 0x1F) * level / 255;
+        palette[i] = (r << 11) | (g << 5) | b;
+    }
+    markAllDirty();
+}
+
+// Undo remaps and fades
+template <class Transport>
+void ILI9341Driver<Transport>::resetPaletteEffects() {
+    for (uint16_t i = 0; i < palette_used; i++) {
+        palette[i] = palette_key[i];
+    }
+    markAllDirty();
+}
+
+// Palette index for an RGB565 colour: cached, then an exact match, then
+// a new entry, then the nearest existing entry once the palette is full
+template <class Transport>
+uint8_t ILI9341Driver<Transport>::colorIndex(uint16_t color) {
+    uint8_t slot = (color ^ (color >> 5) ^ (color >> 11)) & (ILI9341_PALETTE_CACHE - 1);
+    if ((cache_valid & (1 << slot)) && cache_color[slot] == color) {
+        return cache_index[slot];
+    }
+    
+    int found = -1;
+    for (uint16_t i = 0; i < palette_used; i++) {
+        if (palette_key[i] == color) {
+            found = i;
+            break;
+        }
+    }
+    
+    if (found < 0 && palette_used < palette_limit) {
+        found = palette_used;
+        palette_key[found] = color;
+        palette[found] = color;
+        palette_used++;
+    }
+    
+    if (found < 0) {
+        int32_t best = INT32_MAX;
+        for (uint16_t i = 0; i < palette_used; i++) {
+            int32_t dr = (int32_t)(palette_key[i] >> 11) - (color >> 11);
+            int32_t dg = (int32_t)((palette_key[i] >> 5) & 0x3F) - ((color >> 5) & 0x3F);
+            int32_t db = (int32_t)(palette_key[i] & 0x1F) - (color & 0x1F);
+            int32_t d = 4 * dr * dr + dg * dg + 4 * db * db;
+            if (d < best) {
+                best = d;
+                found = i;
+            }
+        }
+    }
+    
+    cache_color[slot] = color;
+    cache_index[slot] = (uint8_t)found;
+    cache_valid |= (1 << slot);
+    return (uint8_t)found;
 }
 
 // Get the framebuffer pointer
-uint16_t* ILI9341Display::getFramebuffer() {
+template <class Transport>
+uint16_t* ILI9341Driver<Transport>::getFramebuffer() {
     return buffer.framebuffer;
 }
 
 // Convert RGB values to RGB565 color
-uint16_t ILI9341Display::rgb(uint8_t r, uint8_t g, uint8_t b) {
+template <class Transport>
+uint16_t ILI9341Driver<Transport>::rgb(uint8_t r, uint8_t g, uint8_t b) {
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
 }
 
 // Set contrast level (0-255)
-void ILI9341Display::setContrast(uint8_t level) {
-    digitalWrite(TFT_CS, LOW);
+template <class Transport>
+void ILI9341Driver<Transport>::setContrast(uint8_t level) {
+    bus.beginTransaction();
     writeCommand(ILI9341_VCOMCTRL1);
     writeData(level);
-    digitalWrite(TFT_CS, HIGH);
+    bus.endTransaction();
 }
 
 // Set brightness level (0-255)
-void ILI9341Display::setBrightness(uint8_t level) {
+template <class Transport>
+void ILI9341Driver<Transport>::setBrightness(uint8_t level) {
     // PWM control on TFT_RST pin if available
     // For now, just adjust contrast
     setContrast(level);
 }
+
+// Explicit instantiations, one per transport
+template class ILI9341Driver<ILI9341SpiTransport>;
+template class ILI9341Driver<ILI9341FastSpiTransport>;
+template class ILI9341Driver<ILI9341DmaSpiTransport>;
+template class ILI9341Driver<ILI9341Parallel8080Transport>;
+template class ILI9341Driver<ILI9341HostSink>;
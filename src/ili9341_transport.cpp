@@ -0,0 +1,295 @@
+#include "../include/ili9341_display.h"
+
+volatile bool ili9341_bus_busy = false;
+volatile bool ili9341_bus_wanted = false;
+
+static ILI9341BusCallback volatile bus_callback = nullptr;
+static void * volatile bus_context = nullptr;
+
+// Ask to be called back when the current transfer lets go of the bus;
+// safe from an interrupt
+void ili9341_requestBus(ILI9341BusCallback callback, void *context) {
+    bus_context = context;
+    __atomic_store_n(&bus_callback, callback, __ATOMIC_RELEASE);
+    ili9341_bus_wanted = true;
+}
+
+// Run the pending request, if any; call with the bus released
+void ili9341_grantBus() {
+    ili9341_bus_wanted = false;
+    ILI9341BusCallback callback = __atomic_exchange_n(&bus_callback, (ILI9341BusCallback)nullptr, __ATOMIC_ACQ_REL);
+    if (callback) {
+        callback(bus_context);
+    }
+}
+
+// ============================================================================
+// Blocking SPI
+// ============================================================================
+
+// Configure CS/DC and start the SPI peripheral
+void ILI9341SpiTransport::begin() {
+    pinMode(TFT_CS, OUTPUT);
+    pinMode(TFT_DC, OUTPUT);
+    digitalWrite(TFT_CS, HIGH);
+    
+    SPI.begin();
+}
+
+// ============================================================================
+// Fast SPI
+// ============================================================================
+
+// Configure CS/DC; on Teensy 4.x hand DC to the LPSPI if it can drive it
+void ILI9341FastSpiTransport::begin() {
+    pinMode(TFT_CS, OUTPUT);
+    pinMode(TFT_DC, OUTPUT);
+    digitalWriteFast(TFT_CS, HIGH);
+    digitalWriteFast(TFT_DC, HIGH);
+    dc_is_data = true;
+    
+    SPI.begin();
+    
+#if defined(__IMXRT1062__)
+    hardware_dc = SPI.pinIsChipSelect(TFT_DC);
+    pcs_data = LPSPI_TCR_PCS(3);
+    pcs_command = pcs_data;
+    if (hardware_dc) {
+        // setCS() returns the 1-based PCS index of the pin
+        pcs_command = LPSPI_TCR_PCS(SPI.setCS(TFT_DC) - 1);
+    }
+#endif
+}
+
+// ============================================================================
+// DMA SPI
+// ============================================================================
+
+#ifdef TEENSYDUINO
+// Transfer-complete callback, run from the DMA interrupt
+void ILI9341DmaSpiTransport::onDone(EventResponderRef event) {
+    ILI9341DmaSpiTransport *self = (ILI9341DmaSpiTransport *)event.getContext();
+    self->busy = false;
+}
+#endif
+
+// Configure the bus and the completion event
+void ILI9341DmaSpiTransport::begin() {
+    ILI9341SpiTransport::begin();
+    
+#ifdef TEENSYDUINO
+    done.setContext(this);
+    done.attachImmediate(&ILI9341DmaSpiTransport::onDone);
+#endif
+}
+
+// Queue one bounce buffer; blocking where DMA is not available
+void ILI9341DmaSpiTransport::startChunk(const uint8_t *bytes, uint32_t count) {
+#ifdef TEENSYDUINO
+    busy = true;
+    SPI.transfer(bytes, nullptr, count, done);
+#else
+    for (uint32_t i = 0; i < count; i++) {
+        SPI.transfer(bytes[i]);
+    }
+#endif
+}
+
+// Send pixels in big-endian byte order, one bounce buffer at a time. The
+// first chunk is packed while the previous call's last chunk may still be
+// on the wire from the other buffer; that can only be pixel data, since
+// commands wait for idle, so DC is already high.
+void ILI9341DmaSpiTransport::writePixels(const uint16_t *pixels, uint32_t count) {
+    digitalWrite(TFT_DC, HIGH);
+    
+    while (count) {
+        uint32_t n = (count < ILI9341_DMA_CHUNK) ? count : ILI9341_DMA_CHUNK;
+        uint8_t *dst = bounce[next_bounce];
+        for (uint32_t i = 0; i < n; i++) {
+            dst[2 * i] = pixels[i] >> 8;
+            dst[2 * i + 1] = pixels[i] & 0xFF;
+        }
+        
+        // The other buffer may still be on the wire
+        waitIdle();
+        startChunk(dst, n * 2);
+        
+        next_bounce ^= 1;
+        pixels += n;
+        count -= n;
+    }
+}
+
+// Send one colour repeatedly; a single prepared buffer is reused, packed
+// while the other one may still be on the wire
+void ILI9341DmaSpiTransport::fillPixels(uint16_t color, uint32_t count) {
+    digitalWrite(TFT_DC, HIGH);
+    
+    uint8_t *dst = bounce[next_bounce];
+    uint32_t n = (count < ILI9341_DMA_CHUNK) ? count : ILI9341_DMA_CHUNK;
+    for (uint32_t i = 0; i < n; i++) {
+        dst[2 * i] = color >> 8;
+        dst[2 * i + 1] = color & 0xFF;
+    }
+    
+    while (count) {
+        n = (count < ILI9341_DMA_CHUNK) ? count : ILI9341_DMA_CHUNK;
+        waitIdle();
+        startChunk(dst, n * 2);
+        count -= n;
+    }
+    next_bounce ^= 1;
+}
+
+// ============================================================================
+// 8080 parallel
+// ============================================================================
+
+// Configure control and data pins, all idle high
+void ILI9341Parallel8080Transport::begin() {
+    static const uint8_t pins[] = {
+        TFT_CS, TFT_DC, TFT_WR, TFT_RD,
+        TFT_D0, TFT_D1, TFT_D2, TFT_D3, TFT_D4, TFT_D5, TFT_D6, TFT_D7
+    };
+    
+    for (uint8_t i = 0; i < sizeof(pins); i++) {
+        pinMode(pins[i], OUTPUT);
+        digitalWriteFast(pins[i], HIGH);
+    }
+}
+
+// ============================================================================
+// Host sink
+// ============================================================================
+
+ILI9341HostSink::ILI9341HostSink() {
+    panel = nullptr;
+    command = 0;
+    param_count = 0;
+    col_start = col_end = row_start = row_end = 0;
+    cursor_x = cursor_y = 0;
+    scroll_start = 0;
+    scroll_fixed_left = 0;
+    scroll_lines = ILI9341_GATE_LINES;
+    scroll_fixed_right = 0;
+    partial_first = 0;
+    partial_last = ILI9341_GATE_LINES - 1;
+    in_transaction = false;
+    pixel_hook = nullptr;
+    hook_context = nullptr;
+    hook_pixels = 0;
+    resetCounters();
+}
+
+ILI9341HostSink::~ILI9341HostSink() {
+    if (panel) {
+        delete[] panel;
+    }
+}
+
+// Allocate the emulated panel memory
+void ILI9341HostSink::begin() {
+    if (!panel) {
+        panel = new uint16_t[ILI9341_SINK_COLUMNS * ILI9341_SINK_ROWS];
+    }
+    memset(panel, 0, ILI9341_SINK_COLUMNS * ILI9341_SINK_ROWS * sizeof(uint16_t));
+}
+
+// Start a new command; memory writes restart at the window origin
+void ILI9341HostSink::writeCommand(uint8_t cmd) {
+    commands++;
+    command = cmd;
+    param_count = 0;
+    
+    if (cmd == ILI9341_MEMWRITE) {
+        cursor_x = col_start;
+        cursor_y = row_start;
+    }
+}
+
+// Decode parameter bytes of the commands the sink understands
+void ILI9341HostSink::feedByte(uint8_t b) {
+    if (command == ILI9341_MEMWRITE) {
+        // Byte-wise pixel data: assemble big-endian pairs
+        params[param_count++] = b;
+        if (param_count == 2) {
+            storePixel((params[0] << 8) | params[1]);
+            param_count = 0;
+        }
+        return;
+    }
+    
+    if (param_count < sizeof(params)) {
+        params[param_count++] = b;
+    }
+    
+    uint16_t first = (params[0] << 8) | params[1];
+    uint16_t second = (params[2] << 8) | params[3];
+    uint16_t third = (params[4] << 8) | params[5];
+    
+    switch (command) {
+        case ILI9341_COLADDRSET:
+            if (param_count == 4) {
+                col_start = first;
+                col_end = second;
+            }
+            break;
+        case ILI9341_ROWADDRSET:
+            if (param_count == 4) {
+                row_start = first;
+                row_end = second;
+            }
+            break;
+        case ILI9341_VSCRSADD:
+            if (param_count == 2) {
+                scroll_start = first;
+            }
+            break;
+        case ILI9341_VSCRDEF:
+            if (param_count == 6) {
+                scroll_fixed_left = first;
+                scroll_lines = second;
+                scroll_fixed_right = third;
+            }
+            break;
+        case ILI9341_PARTIALAREA:
+            if (param_count == 4) {
+                partial_first = first;
+                partial_last = second;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Gate lines inside the scroll area show memory from VSCRSADD onwards,
+// wrapping within the area
+uint16_t ILI9341HostSink::shownAt(uint16_t x, uint16_t y) const {
+    uint16_t end = scroll_fixed_left + scroll_lines;
+    if (x >= scroll_fixed_left && x < end && scroll_start >= scroll_fixed_left && scroll_start < end) {
+        x = scroll_start + (x - scroll_fixed_left);
+        if (x >= end) x -= scroll_lines;
+    }
+    return pixelAt(x, y);
+}
+
+// Write one pixel at the cursor and advance through the window
+void ILI9341HostSink::storePixel(uint16_t pixel) {
+    pixels++;
+    
+    if (panel && cursor_x < ILI9341_SINK_COLUMNS && cursor_y < ILI9341_SINK_ROWS) {
+        panel[cursor_y * ILI9341_SINK_COLUMNS + cursor_x] = pixel;
+    }
+    
+    if (cursor_x >= col_end) {
+        cursor_x = col_start;
+        cursor_y = (cursor_y >= row_end) ? row_start : cursor_y + 1;
+    } else {
+        cursor_x++;
+    }
+    
+    if (pixel_hook && in_transaction && hook_pixels && pixels % hook_pixels == 0) {
+        pixel_hook(hook_context);
+    }
+}
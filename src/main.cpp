@@ -15,6 +15,12 @@
  * SCK         -> Pin 13 (SPI SCK)
  * MISO        -> Pin 12 (SPI MISO) - optional for reading
  * 
+ * XPT2046 touch controller, if the module has one (shares the SPI bus):
+ * T_CS        -> Pin 6
+ * T_CLK       -> Pin 13
+ * T_DIN       -> Pin 11
+ * T_DO        -> Pin 12
+ * 
  * Teensy 4.x recommended for performance
  */
 
@@ -24,26 +30,31 @@
 // Global display objects
 ILI9341Display *tft = nullptr;
 PazervilleDisplay *pazerville = nullptr;
+PazervilleTouch touch;
 
 // Simulation parameters
 float sim_time = 0.0f;
-uint32_t last_update = 0;
-uint32_t frame_count = 0;
-float fps = 0.0f;
 
 // Control parameters
 float spring_strength = 0.15f;
 float damping_factor = 0.92f;
 
+// Force fields driven by addTimeBasedForces()
+int pulse_field = -1;
+int orbit_field = -1;
+
 void setup() {
     Serial.begin(115200);
     delay(1000);
     
     Serial.println("Initializing Pazerville ILI9341 Display...");
     
-    // Initialize display
+    // Initialize display. RGB565 keeps anti-aliased edges and motion
+    // trails, which blend into the framebuffer; ILI9341_COLOR_INDEXED8
+    // halves the RAM and fill bandwidth, but edges are then aliased and
+    // trails are cleared each frame.
     tft = new ILI9341Display();
-    if (!tft->initialize()) {
+    if (!tft->initialize(ILI9341_COLOR_RGB565)) {
         Serial.println("ERROR: Failed to initialize ILI9341 display");
         while (1) {
             delay(100);
@@ -70,37 +81,43 @@ void setup() {
     
     // Create a test network graph
     createTestNetwork();
+    createForceFields();
+    
+    // FPS, step time and graph statistics on screen instead of Serial
+    pazerville->setHUD(true);
+    
+    // Two physics steps per frame for stability, but never more than half
+    // of a 60 FPS frame; heavy graphs get fewer, longer steps instead
+    pazerville->setPhysicsGovernor(2, 0.5f);
+    
+    // Touch is sampled from a timer and waits out panel transfers; nodes
+    // can be dragged with the pen. Modules without a controller are
+    // detected here and never sampled.
+    if (touch.begin(PAZERVILLE_TOUCH_CS)) {
+        Serial.println("Touch controller found");
+    } else {
+        Serial.println("No touch controller answered; dragging disabled");
+    }
     
     Serial.println("Setup complete!");
-    last_update = millis();
 }
 
 void loop() {
-    uint32_t current_time = millis();
-    uint32_t dt = current_time - last_update;
+    // Add some interactive forces based on time
+    addTimeBasedForces(sim_time);
     
-    // Update simulation
-    for (int i = 0; i < 2; i++) {  // Run physics twice per frame for stability
-        pazerville->update();
+    // Pick up, drag and drop nodes with the pen
+    PazervilleTouchPoint point;
+    if (touch.read(&point)) {
+        pazerville->handleTouch(point);
     }
     
-    // Add some interactive forces based on time
-    addTimeBasedForces(sim_time);
+    // Update simulation within the physics budget
+    pazerville->simulate();
     
-    // Draw the graph
+    // Draw the graph and the statistics overlay
     pazerville->draw();
     
-    // Update timing
-    frame_count++;
-    if (current_time - last_update >= 1000) {
-        fps = frame_count / ((current_time - last_update) / 1000.0f);
-        frame_count = 0;
-        last_update = current_time;
-        
-        Serial.print("FPS: ");
-        Serial.println(fps);
-    }
-    
     sim_time += 0.016f;
     
     // Small delay to prevent overwhelming the system
@@ -117,8 +134,8 @@ void createTestNetwork() {
     
     for (int i = 0; i < num_nodes; i++) {
         float angle = (2.0f * PI * i) / num_nodes;
-        float x = center_x + radius * cos(angle);
-        float y = center_y + radius * sin(angle);
+        float x = center_x + radius * pzCos(angle);
+        float y = center_y + radius * pzSin(angle);
         uint16_t color = getColorFromIndex(i);
         
         pazerville->addNode(x, y, 1.5f, color, 4);
@@ -157,39 +174,39 @@ uint16_t getColorFromIndex(int index) {
     }
 }
 
-// Add forces to the network based on time
-void addTimeBasedForces(float time) {
-    // Create a pulsing effect
-    float pulse = sin(time * 2.0f) * 100.0f;
-    
-    // Apply repulsive force from center periodically
-    if ((int)(time * 2) % 2 == 0) {
-        for (int i = 0; i < pazerville->getNodeCount() - 1; i++) {
-            float center_x = PAZERVILLE_WIDTH / 2.0f;
-            float center_y = PAZERVILLE_HEIGHT / 2.0f;
-            
-            PazervilleNode *node = pazerville->getNode(i);
-            if (node) {
-                float dx = node->x - center_x;
-                float dy = node->y - center_y;
-                float dist = sqrt(dx * dx + dy * dy);
-                
-                if (dist > 0.1f) {
-                    float force = pulse * 0.001f;
-                    pazerville->repelNode(i, (dx / dist) * force, (dy / dist) * force);
-                }
-            }
-        }
+// Register the fields animated by addTimeBasedForces()
+void createForceFields() {
+    float center_x = PAZERVILLE_WIDTH / 2.0f;
+    float center_y = PAZERVILLE_HEIGHT / 2.0f;
+    
+    // Pulse pushes the peripheral nodes (not the centre node) off the centre
+    pulse_field = pazerville->addForceField(PAZERVILLE_FIELD_RADIAL, center_x, center_y, 0.0f);
+    PazervilleForceField *pulse = pazerville->getForceField(pulse_field);
+    if (pulse) {
+        pulse->last_node = pazerville->getNodeCount() - 1;
+        pulse->mass_scaled = true;
     }
     
-    // Apply attracting forces in a rotating pattern
-    float angle = time * 2.0f;
-    float target_x = PAZERVILLE_WIDTH / 2.0f + 50 * cos(angle);
-    float target_y = PAZERVILLE_HEIGHT / 2.0f + 50 * sin(angle);
+    // Rotating attractor acting on every node
+    orbit_field = pazerville->addForceField(PAZERVILLE_FIELD_ATTRACTOR, center_x, center_y, 50.0f);
+}
+
+// Animate the force fields based on time. The changes go through the
+// command queue, so they land together at the start of the next
+// simulate() and could equally be posted from a timer interrupt.
+void addTimeBasedForces(float time) {
+    PazervilleCommandQueue &commands = pazerville->getCommands();
+    float center_x = PAZERVILLE_WIDTH / 2.0f;
+    float center_y = PAZERVILLE_HEIGHT / 2.0f;
     
-    for (int i = 0; i < pazerville->getNodeCount(); i++) {
-        pazerville->attractToPoint(i, target_x, target_y, 50.0f);
-    }
+    // Create a pulsing effect, applied from the centre periodically
+    bool pulsing = ((int)(time * 2) % 2 == 0);
+    float pulse = pulsing ? pzSin(time * 2.0f) * 100.0f * 0.001f : 0.0f;
+    commands.postField(pulse_field, pulse, center_x, center_y);
+    
+    // Move the attractor in a rotating pattern
+    float angle = time * 2.0f;
+    commands.postField(orbit_field, 50.0f, center_x + 50 * pzCos(angle), center_y + 50 * pzSin(angle));
 }
 
 // Optional: Add user interaction via serial commands
@@ -212,7 +229,7 @@ void handleSerialInput() {
                 // Increase damping
                 damping_factor += 0.01f;
                 if (damping_factor > 0.99f) damping_factor = 0.99f;
-                pazerville->setDamping(damping_factor);
+                pazerville->getCommands().postValue(PAZERVILLE_CMD_SET_DAMPING, damping_factor);
                 Serial.print("Damping: ");
                 Serial.println(damping_factor);
                 break;
@@ -220,7 +237,7 @@ void handleSerialInput() {
                 // Decrease damping
                 damping_factor -= 0.01f;
                 if (damping_factor < 0.8f) damping_factor = 0.8f;
-                pazerville->setDamping(damping_factor);
+                pazerville->getCommands().postValue(PAZERVILLE_CMD_SET_DAMPING, damping_factor);
                 Serial.print("Damping: ");
                 Serial.println(damping_factor);
                 break;
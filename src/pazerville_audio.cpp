@@ -0,0 +1,232 @@
+#include "../include/pazerville_audio.h"
+#include "../include/pazerville_math.h"
+
+// Mailbox flag: the spare buffer holds a frame the consumer has not seen
+
+// Bin magnitude of a full-scale sine after the Hann window and the 1/N
+// scaling of the FFT stages; used to normalise bands to 0.0 - 1.0
+#define PAZERVILLE_AUDIO_FULL_SCALE 8192.0f
+
+#ifdef TEENSYDUINO
+static IntervalTimer audio_timer;
+static PazervilleAudio *audio_instance = nullptr;
+static uint8_t audio_pin = 0;
+
+// Sampling interrupt: one conversion per tick, nothing else
+static void audioSampleISR() {
+    int sample = analogRead(audio_pin);
+    audio_instance->pushSample((int16_t)((sample - 2048) << 4));
+}
+#endif
+
+// Constructor
+PazervilleAudio::PazervilleAudio() {
+    capture_block = 0;
+    capture_pos = 0;
+    ready_block = 0;
+    capture_ready = false;
+    dropped_blocks = 0;
+    smoothing = 0.5f;
+    peak_release = 0.9f;
+    block_count = 0;
+    sample_rate = PAZERVILLE_AUDIO_SAMPLE_RATE;
+    input_pin = 0;
+    
+    for (int i = 0; i < PAZERVILLE_AUDIO_BANDS; i++) {
+        smooth_band[i] = 0.0f;
+        peak_band[i] = 0.0f;
+    }
+    
+    computeTables();
+    computeBands();
+}
+
+// Build the Hann window and FFT twiddle factors (Q15)
+void PazervilleAudio::computeTables() {
+    const float two_pi = 6.28318530718f;
+    
+    for (int i = 0; i < PAZERVILLE_AUDIO_BLOCK_SIZE; i++) {
+        float w = 0.5f - 0.5f * cosf(two_pi * i / (PAZERVILLE_AUDIO_BLOCK_SIZE - 1));
+        window[i] = (int16_t)(w * 32767.0f);
+    }
+    
+    for (int i = 0; i < PAZERVILLE_AUDIO_BLOCK_SIZE / 2; i++) {
+        float angle = two_pi * i / PAZERVILLE_AUDIO_BLOCK_SIZE;
+        twiddle_cos[i] = (int16_t)(cosf(angle) * 32767.0f);
+        twiddle_sin[i] = (int16_t)(sinf(angle) * 32767.0f);
+    }
+}
+
+// Map the bands onto FFT bins, log-spaced from PAZERVILLE_AUDIO_MIN_FREQ
+// to Nyquist, with at least one bin per band
+void PazervilleAudio::computeBands() {
+    const int half = PAZERVILLE_AUDIO_BLOCK_SIZE / 2;
+    float nyquist = sample_rate / 2.0f;
+    float ratio = nyquist / PAZERVILLE_AUDIO_MIN_FREQ;
+    
+    for (int b = 0; b <= PAZERVILLE_AUDIO_BANDS; b++) {
+        float freq = PAZERVILLE_AUDIO_MIN_FREQ * powf(ratio, (float)b / PAZERVILLE_AUDIO_BANDS);
+        int bin = (int)(freq * PAZERVILLE_AUDIO_BLOCK_SIZE / sample_rate + 0.5f);
+        
+        if (bin < 1) bin = 1;
+        if (b > 0 && bin <= band_start[b - 1]) bin = band_start[b - 1] + 1;
+        if (bin > half) bin = half;
+        band_start[b] = bin;
+    }
+    band_start[PAZERVILLE_AUDIO_BANDS] = half;
+}
+
+// Start sampling an analog pin in the background
+bool PazervilleAudio::begin(uint8_t pin, uint32_t rate) {
+    input_pin = pin;
+    setSampleRate(rate);
+    
+#ifdef TEENSYDUINO
+    audio_instance = this;
+    audio_pin = pin;
+    analogReadResolution(12);
+    analogReadAveraging(1);  // keep the conversion in the ISR short
+    return audio_timer.begin(audioSampleISR, 1000000.0f / rate);
+#else
+    return false;
+#endif
+}
+
+// Stop background sampling
+void PazervilleAudio::end() {
+#ifdef TEENSYDUINO
+    audio_timer.end();
+    audio_instance = nullptr;
+#endif
+}
+
+// Set the sample rate and rebuild the band map
+void PazervilleAudio::setSampleRate(uint32_t rate) {
+    sample_rate = rate;
+    computeBands();
+}
+
+// Add one sample. A full block is handed to read() if the other buffer
+// is free; otherwise it is dropped and the same buffer is refilled, so
+// the consumer never sees a block change under it.
+void PazervilleAudio::pushSample(int16_t sample) {
+    capture[capture_block][capture_pos++] = sample;
+    if (capture_pos < PAZERVILLE_AUDIO_BLOCK_SIZE) return;
+    
+    capture_pos = 0;
+    if (__atomic_load_n(&capture_ready, __ATOMIC_ACQUIRE)) {
+        dropped_blocks = dropped_blocks + 1;
+        return;
+    }
+    
+    ready_block = capture_block;
+    capture_block ^= 1;
+    __atomic_store_n(&capture_ready, true, __ATOMIC_RELEASE);
+}
+
+// In-place radix-2 decimation-in-time FFT on fft_re/fft_im.
+// Each stage halves its outputs, so the result is scaled by 1/N and
+// cannot overflow Q15.
+void PazervilleAudio::runFFT() {
+    const int n = PAZERVILLE_AUDIO_BLOCK_SIZE;
+    
+    // Bit-reverse reorder
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        
+        if (i < j) {
+            int16_t t = fft_re[i]; fft_re[i] = fft_re[j]; fft_re[j] = t;
+            t = fft_im[i]; fft_im[i] = fft_im[j]; fft_im[j] = t;
+        }
+    }
+    
+    // Butterflies
+    for (int size = 2; size <= n; size <<= 1) {
+        int half = size >> 1;
+        int step = n / size;
+        
+        for (int start = 0; start < n; start += size) {
+            for (int k = 0; k < half; k++) {
+                int32_t wr = twiddle_cos[k * step];
+                int32_t wi = -twiddle_sin[k * step];
+                int i = start + k;
+                int j = i + half;
+                
+                int32_t tr = (fft_re[j] * wr - fft_im[j] * wi) >> 15;
+                int32_t ti = (fft_re[j] * wi + fft_im[j] * wr) >> 15;
+                int32_t ur = fft_re[i];
+                int32_t ui = fft_im[i];
+                
+                fft_re[j] = (int16_t)((ur - tr) >> 1);
+                fft_im[j] = (int16_t)((ui - ti) >> 1);
+                fft_re[i] = (int16_t)((ur + tr) >> 1);
+                fft_im[i] = (int16_t)((ui + ti) >> 1);
+            }
+        }
+    }
+}
+
+// Analyse one block of samples and publish the result
+void PazervilleAudio::processBlock(const int16_t *samples) {
+    // Window and time-domain energy
+    int64_t energy = 0;
+    for (int i = 0; i < PAZERVILLE_AUDIO_BLOCK_SIZE; i++) {
+        int32_t s = samples[i];
+        energy += s * s;
+        fft_re[i] = (int16_t)((s * window[i]) >> 15);
+        fft_im[i] = 0;
+    }
+    
+    runFFT();
+    
+    PazervilleAudioFrame &frame = frames.slot();
+    
+    // Band RMS magnitudes, smoothed and peak-followed
+    for (int b = 0; b < PAZERVILLE_AUDIO_BANDS; b++) {
+        float power = 0.0f;
+        int first = band_start[b];
+        int last = band_start[b + 1];
+        
+        for (int k = first; k < last; k++) {
+            int32_t re = fft_re[k];
+            int32_t im = fft_im[k];
+            power += (float)(re * re + im * im);
+        }
+        
+        float value = 0.0f;
+        if (last > first) {
+            value = pzSqrt(power / (last - first)) / PAZERVILLE_AUDIO_FULL_SCALE;
+        }
+        if (value > 1.0f) value = 1.0f;
+        
+        smooth_band[b] += (value - smooth_band[b]) * smoothing;
+        if (value > peak_band[b]) {
+            peak_band[b] = value;
+        } else {
+            peak_band[b] *= peak_release;
+        }
+        
+        frame.band[b] = smooth_band[b];
+        frame.peak[b] = peak_band[b];
+    }
+    
+    frame.rms = pzSqrt((float)energy / PAZERVILLE_AUDIO_BLOCK_SIZE) / 32768.0f;
+    frame.block_index = block_count++;
+    
+    frames.publish();
+}
+
+// Analyse a captured block if one is waiting, then copy out the newest
+// frame if one arrived since the last call
+bool PazervilleAudio::read(PazervilleAudioFrame *frame) {
+    if (__atomic_load_n(&capture_ready, __ATOMIC_ACQUIRE)) {
+        processBlock(capture[ready_block]);
+        __atomic_store_n(&capture_ready, false, __ATOMIC_RELEASE);
+    }
+    
+    return frames.read(frame);
+}
@@ -0,0 +1,119 @@
+#include "../include/pazerville_commands.h"
+
+#define PAZERVILLE_COMMAND_MASK (PAZERVILLE_COMMAND_SLOTS - 1)
+
+// Constructor
+PazervilleCommandQueue::PazervilleCommandQueue() {
+    for (uint32_t i = 0; i < PAZERVILLE_COMMAND_SLOTS; i++) {
+        slots[i].sequence = i;
+    }
+    tail = 0;
+    head = 0;
+    dropped = 0;
+}
+
+// Claim the slot at the tail, fill it and publish it. A producer that
+// loses the race for a slot retries on the next one; an interrupt that
+// preempts a producer between claim and publish simply takes a later
+// slot, and the consumer stops at the unpublished one until it is done.
+bool PazervilleCommandQueue::post(const PazervilleCommand &command) {
+    uint32_t pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    Slot *slot;
+    
+    for (;;) {
+        slot = &slots[pos & PAZERVILLE_COMMAND_MASK];
+        uint32_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        
+        if (diff == 0) {
+            // Free at this position; on failure 'pos' is reloaded
+            if (__atomic_compare_exchange_n(&tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Still holds a command from one lap ago: full
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        }
+    }
+    
+    slot->command = command;
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Post a parameter change
+bool PazervilleCommandQueue::postValue(PazervilleCommandType type, float value) {
+    PazervilleCommand command;
+    command.type = type;
+    command.value = value;
+    return post(command);
+}
+
+// Post new strength and position for a force field
+bool PazervilleCommandQueue::postField(int field, float strength, float x, float y) {
+    PazervilleCommand command;
+    command.type = PAZERVILLE_CMD_SET_FIELD;
+    command.field.index = field;
+    command.field.strength = strength;
+    command.field.x = x;
+    command.field.y = y;
+    return post(command);
+}
+
+// Post an impulse or repel on a node
+bool PazervilleCommandQueue::postForce(PazervilleCommandType type, PazervilleHandle node, float fx, float fy) {
+    PazervilleCommand command;
+    command.type = type;
+    command.force.node = node;
+    command.force.fx = fx;
+    command.force.fy = fy;
+    return post(command);
+}
+
+// Post a new node
+bool PazervilleCommandQueue::postAddNode(float x, float y, float mass, uint16_t color, uint8_t radius) {
+    PazervilleCommand command;
+    command.type = PAZERVILLE_CMD_ADD_NODE;
+    command.add_node.x = x;
+    command.add_node.y = y;
+    command.add_node.mass = mass;
+    command.add_node.color = color;
+    command.add_node.radius = radius;
+    return post(command);
+}
+
+// Post a new edge between two existing nodes
+bool PazervilleCommandQueue::postAddEdge(PazervilleHandle node1, PazervilleHandle node2, float spring_constant, float rest_length) {
+    PazervilleCommand command;
+    command.type = PAZERVILLE_CMD_ADD_EDGE;
+    command.add_edge.node1 = node1;
+    command.add_edge.node2 = node2;
+    command.add_edge.spring_constant = spring_constant;
+    command.add_edge.rest_length = rest_length;
+    return post(command);
+}
+
+// Post the removal of a node or edge
+bool PazervilleCommandQueue::postRemove(PazervilleCommandType type, PazervilleHandle target) {
+    PazervilleCommand command;
+    command.type = type;
+    command.target = target;
+    return post(command);
+}
+
+// Take the oldest command once its producer has published it
+bool PazervilleCommandQueue::pop(PazervilleCommand *command) {
+    Slot &slot = slots[head & PAZERVILLE_COMMAND_MASK];
+    uint32_t seq = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+    if (seq != head + 1) {
+        return false;
+    }
+    
+    *command = slot.command;
+    __atomic_store_n(&slot.sequence, head + PAZERVILLE_COMMAND_SLOTS, __ATOMIC_RELEASE);
+    head++;
+    return true;
+}
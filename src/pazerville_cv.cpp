@@ -0,0 +1,152 @@
+#include "../include/pazerville_cv.h"
+#include "../include/pazerville_math.h"
+
+#ifdef TEENSYDUINO
+static IntervalTimer cv_timer;
+static PazervilleCV *cv_instance = nullptr;
+
+// Sampling interrupt: one pass over all channels per tick
+static void cvSampleISR() {
+    cv_instance->sampleTick();
+}
+#endif
+
+// Constructor
+PazervilleCV::PazervilleCV() {
+    channel_count = 0;
+    source = nullptr;
+    sample_rate = PAZERVILLE_CV_SAMPLE_RATE;
+    
+    for (int i = 0; i < PAZERVILLE_CV_MAX_CHANNELS; i++) {
+        channels[i].active = false;
+    }
+}
+
+// Add an input channel
+int PazervilleCV::addChannel(uint8_t pin, float out_min, float out_max, PazervilleCurve curve) {
+    if (channel_count >= PAZERVILLE_CV_MAX_CHANNELS) {
+        return -1;
+    }
+    
+    PazervilleCVChannel &ch = channels[channel_count];
+    ch.pin = pin;
+    ch.median = true;
+    ch.smoothing = 0.1f;
+    ch.curve = curve;
+    ch.out_min = out_min;
+    ch.out_max = out_max;
+    ch.head = 0;
+    ch.filtered = 0.0f;
+    for (int i = 0; i < PAZERVILLE_CV_RING_SIZE; i++) {
+        ch.ring[i] = 0;
+    }
+    ch.active = true;
+    
+    return channel_count++;
+}
+
+// Start sampling in the background
+bool PazervilleCV::begin(uint32_t rate) {
+    sample_rate = rate;
+    
+#ifdef TEENSYDUINO
+    cv_instance = this;
+    analogReadResolution(12);
+    return cv_timer.begin(cvSampleISR, 1000000.0f / rate);
+#else
+    return false;
+#endif
+}
+
+// Stop background sampling
+void PazervilleCV::end() {
+#ifdef TEENSYDUINO
+    cv_timer.end();
+    cv_instance = nullptr;
+#endif
+}
+
+// Median of the newest PAZERVILLE_CV_MEDIAN_TAPS raw samples
+uint16_t PazervilleCV::medianOf(const PazervilleCVChannel &ch) {
+    uint16_t taps[PAZERVILLE_CV_MEDIAN_TAPS];
+    int count = (ch.head < PAZERVILLE_CV_MEDIAN_TAPS) ? ch.head : PAZERVILLE_CV_MEDIAN_TAPS;
+    
+    // Insertion sort; five elements
+    for (int i = 0; i < count; i++) {
+        uint16_t v = ch.ring[(ch.head - 1 - i) & (PAZERVILLE_CV_RING_SIZE - 1)];
+        int j = i;
+        while (j > 0 && taps[j - 1] > v) {
+            taps[j] = taps[j - 1];
+            j--;
+        }
+        taps[j] = v;
+    }
+    
+    return taps[count / 2];
+}
+
+// Convert, store and filter one sample for every channel
+void PazervilleCV::sampleTick() {
+    uint32_t now = micros();
+    
+    for (int i = 0; i < channel_count; i++) {
+        PazervilleCVChannel &ch = channels[i];
+        if (!ch.active) continue;
+        
+        uint16_t raw = source ? source(i, now) : (uint16_t)analogRead(ch.pin);
+        ch.ring[ch.head & (PAZERVILLE_CV_RING_SIZE - 1)] = raw;
+        ch.head = ch.head + 1;
+        
+        uint16_t value = ch.median ? medianOf(ch) : raw;
+        float x = (float)value / PAZERVILLE_CV_FULL_SCALE;
+        
+        // First sample seeds the filter so it does not ramp up from zero
+        if (ch.head == 1) {
+            ch.filtered = x;
+        } else {
+            ch.filtered = ch.filtered + (x - ch.filtered) * ch.smoothing;
+        }
+    }
+}
+
+// Shape a normalised value with a response curve
+float PazervilleCV::applyCurve(PazervilleCurve curve, float x) {
+    if (x < 0.0f) x = 0.0f;
+    if (x > 1.0f) x = 1.0f;
+    
+    switch (curve) {
+        case PAZERVILLE_CURVE_EXPONENTIAL:
+            return x * x;
+        case PAZERVILLE_CURVE_LOGARITHMIC:
+            return pzSqrt(x);
+        case PAZERVILLE_CURVE_SCURVE:
+            return x * x * (3.0f - 2.0f * x);
+        case PAZERVILLE_CURVE_LINEAR:
+        default:
+            return x;
+    }
+}
+
+// Filtered value, before the curve and output mapping
+float PazervilleCV::readNormalized(int idx) {
+    if (idx < 0 || idx >= channel_count) return 0.0f;
+    
+    return channels[idx].filtered;
+}
+
+// Filtered value mapped to the channel's output range
+float PazervilleCV::read(int idx) {
+    if (idx < 0 || idx >= channel_count) return 0.0f;
+    
+    const PazervilleCVChannel &ch = channels[idx];
+    return ch.out_min + (ch.out_max - ch.out_min) * applyCurve(ch.curve, ch.filtered);
+}
+
+// Newest unfiltered conversion
+uint16_t PazervilleCV::readRaw(int idx) {
+    if (idx < 0 || idx >= channel_count) return 0;
+    
+    const PazervilleCVChannel &ch = channels[idx];
+    if (ch.head == 0) return 0;
+    return ch.ring[(ch.head - 1) & (PAZERVILLE_CV_RING_SIZE - 1)];
+}
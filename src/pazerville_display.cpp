@@ -1,10 +1,74 @@
 #include "../include/pazerville_display.h"
 
 // Constructor
-PazervilleDisplay::PazervilleDisplay(ILI9341Display *tft_display) {
+PazervilleDisplay::PazervilleDisplay(ILI9341Display *tft_display) : hud(tft_display) {
     display = tft_display;
     node_count = 0;
     edge_count = 0;
+    active_node_count = 0;
+    active_edge_count = 0;
+    node_free_head = -1;
+    edge_free_head = -1;
+    topology_revision = 0;
+    field_count = 0;
+    has_impulses = false;
+    morph_step = 0;
+    morph_steps = 0;
+    active_set = false;
+    settle_speed = PAZERVILLE_SETTLE_SPEED;
+    settle_hops = PAZERVILLE_SETTLE_HOPS;
+    awake_node_count = 0;
+    for (int i = 0; i < PAZERVILLE_MAX_FIELDS; i++) {
+        field_seen[i].active = false;
+    }
+    auto_resolution = false;
+    half_res_nodes = PAZERVILLE_HALF_RES_NODES;
+    half_res_edges = PAZERVILLE_HALF_RES_EDGES;
+    collisions = false;
+    solver = PAZERVILLE_SOLVER_SPRINGS;
+    solver_iterations = PAZERVILLE_SOLVER_ITERATIONS;
+    restitution = PAZERVILLE_COLLISION_RESTITUTION;
+    sweep_count = 0;
+    collision_pairs = 0;
+    node_style = PAZERVILLE_NODE_CLASSIC;
+    sprite_nodes = true;
+    smooth_edges = true;
+    trails = false;
+    trail_keep = PAZERVILLE_TRAIL_KEEP;
+    hud_enabled = false;
+    last_draw_us = 0;
+    fps = 0.0f;
+    step_time_us = 0.0f;
+    frame_budget_us = 0;
+    lod = PAZERVILLE_LOD_FULL;
+    lod_over = 0;
+    lod_under = 0;
+    frame_count = 0;
+    raster_time_us = 0.0f;
+    flush_time_us = 0.0f;
+    frame_cost_us = 0.0f;
+    physics_substeps = PAZERVILLE_PHYSICS_SUBSTEPS;
+    physics_share = 0.0f;
+    physics_credit_us = 0.0f;
+    physics_owed = 0.0f;
+    last_substeps = 0;
+    physics_degraded = false;
+    degraded_frames = 0;
+    commands_applied = 0;
+    hit_reach = 0;
+    hit_grid_valid = false;
+    hit_grid_revision = 0;
+    drag_node = -1;
+    drag_generation = 0;
+    drag_was_frozen = false;
+    drag_vx = 0.0f;
+    drag_vy = 0.0f;
+    drag_time_us = 0;
+    touch_held = false;
+    touch_pending = false;
+    touch_sample_us = 0;
+    touch_latency_us = 0.0f;
+    last_touch_latency_us = 0.0f;
     damping = 0.95f;
     gravity = 0.0f;
     time_step = 0.01f;
@@ -13,9 +77,22 @@ PazervilleDisplay::PazervilleDisplay(ILI9341Display *tft_display) {
     // Initialize all nodes and edges
     for (int i = 0; i < PAZERVILLE_MAX_NODES; i++) {
         nodes[i].active = false;
+        nodes[i].frozen = false;
+        nodes[i].asleep = false;
+        nodes[i].calm_steps = 0;
+        nodes[i].generation = 0;
+        node_morph[i].state = PAZERVILLE_MORPH_NONE;
+        node_morph[i].froze = false;
+        impulse_x[i] = 0.0f;
+        impulse_y[i] = 0.0f;
     }
     for (int i = 0; i < PAZERVILLE_MAX_EDGES; i++) {
         edges[i].active = false;
+        edges[i].generation = 0;
+        edge_morph[i].state = PAZERVILLE_MORPH_NONE;
+    }
+    for (int i = 0; i < PAZERVILLE_MAX_FIELDS; i++) {
+        fields[i].active = false;
     }
 }
 
@@ -26,81 +103,924 @@ PazervilleDisplay::~PazervilleDisplay() {
 
 // Initialize Pazerville display
 bool PazervilleDisplay::initialize() {
-    if (!display || !display->getFramebuffer()) {
+    if (!display || !display->hasFramebuffer()) {
         return false;
     }
     
     display->fillScreen(COLOR_BLACK);
+    hud.invalidate();
     is_initialized = true;
     return true;
 }
 
+// Take a node slot from the free list, or append one; -1 if full
+int PazervilleDisplay::allocNode() {
+    int idx;
+    if (node_free_head >= 0) {
+        idx = node_free_head;
+        node_free_head = node_next_free[idx];
+    } else if (node_count < PAZERVILLE_MAX_NODES) {
+        idx = node_count++;
+    } else {
+        return -1;
+    }
+    
+    // New generation invalidates any handle left over from a clear()
+    nodes[idx].generation++;
+    node_morph[idx].state = PAZERVILLE_MORPH_NONE;
+    node_morph[idx].froze = false;
+    impulse_x[idx] = 0.0f;
+    impulse_y[idx] = 0.0f;
+    active_node_count++;
+    topology_revision++;
+    return idx;
+}
+
+// Take an edge slot from the free list, or append one; -1 if full
+int PazervilleDisplay::allocEdge() {
+    int idx;
+    if (edge_free_head >= 0) {
+        idx = edge_free_head;
+        edge_free_head = edge_next_free[idx];
+    } else if (edge_count < PAZERVILLE_MAX_EDGES) {
+        idx = edge_count++;
+    } else {
+        return -1;
+    }
+    
+    edges[idx].generation++;
+    edge_morph[idx].state = PAZERVILLE_MORPH_NONE;
+    active_edge_count++;
+    topology_revision++;
+    return idx;
+}
+
+// Return an edge slot to the free list
+void PazervilleDisplay::releaseEdge(int idx) {
+    wakeNode(edges[idx].node1);
+    wakeNode(edges[idx].node2);
+    edges[idx].active = false;
+    edges[idx].generation++;
+    edge_next_free[idx] = edge_free_head;
+    edge_free_head = idx;
+    active_edge_count--;
+    topology_revision++;
+}
+
+// An edge is live only while both endpoints are the nodes it was created
+// with; removing a node bumps its generation, which retires its edges
+bool PazervilleDisplay::edgeEndpointsValid(const PazervilleEdge &edge) const {
+    const PazervilleNode &n1 = nodes[edge.node1];
+    const PazervilleNode &n2 = nodes[edge.node2];
+    return n1.active && n2.active &&
+           n1.generation == edge.node1_generation &&
+           n2.generation == edge.node2_generation;
+}
+
 // Add a node to the graph
-void PazervilleDisplay::addNode(float x, float y, float mass, uint16_t color, uint8_t radius) {
-    if (node_count >= PAZERVILLE_MAX_NODES) {
-        return;
+PazervilleHandle PazervilleDisplay::addNode(float x, float y, float mass, uint16_t color, uint8_t radius) {
+    PazervilleHandle handle = { -1, 0 };
+    int idx = allocNode();
+    if (idx < 0) {
+        return handle;
     }
     
-    nodes[node_count].x = x;
-    nodes[node_count].y = y;
-    nodes[node_count].vx = 0.0f;
-    nodes[node_count].vy = 0.0f;
-    nodes[node_count].mass = mass;
-    nodes[node_count].color = color;
-    nodes[node_count].radius = radius;
-    nodes[node_count].active = true;
-    nodes[node_count].id = node_count;
+    nodes[idx].x = x;
+    nodes[idx].y = y;
+    nodes[idx].vx = 0.0f;
+    nodes[idx].vy = 0.0f;
+    nodes[idx].mass = mass;
+    nodes[idx].inv_mass = 1.0f / mass;
+    nodes[idx].color = color;
+    nodes[idx].radius = radius;
+    nodes[idx].active = true;
+    nodes[idx].frozen = false;
+    nodes[idx].id = idx;
+    wakeNode(idx);
     
-    node_count++;
+    handle.index = idx;
+    handle.generation = nodes[idx].generation;
+    return handle;
 }
 
 // Add an edge between two nodes
-void PazervilleDisplay::addEdge(int node1, int node2, float spring_constant, float rest_length) {
-    if (edge_count >= PAZERVILLE_MAX_EDGES) {
-        return;
-    }
+PazervilleHandle PazervilleDisplay::addEdge(int node1, int node2, float spring_constant, float rest_length) {
+    PazervilleHandle handle = { -1, 0 };
     if (node1 < 0 || node1 >= node_count || node2 < 0 || node2 >= node_count) {
+        return handle;
+    }
+    if (!nodes[node1].active || !nodes[node2].active) {
+        return handle;
+    }
+    
+    int idx = allocEdge();
+    if (idx < 0) {
+        return handle;
+    }
+    
+    edges[idx].node1 = node1;
+    edges[idx].node2 = node2;
+    edges[idx].node1_generation = nodes[node1].generation;
+    edges[idx].node2_generation = nodes[node2].generation;
+    edges[idx].spring_constant = spring_constant;
+    edges[idx].rest_length = rest_length;
+    edges[idx].compliance = -1.0f;
+    edges[idx].color = COLOR_GRAY;
+    edges[idx].active = true;
+    wakeNode(node1);
+    wakeNode(node2);
+    
+    handle.index = idx;
+    handle.generation = edges[idx].generation;
+    return handle;
+}
+
+// Add an edge between two node handles
+PazervilleHandle PazervilleDisplay::addEdge(PazervilleHandle node1, PazervilleHandle node2, float spring_constant, float rest_length) {
+    if (!isValidNode(node1) || !isValidNode(node2)) {
+        PazervilleHandle handle = { -1, 0 };
+        return handle;
+    }
+    return addEdge(node1.index, node2.index, spring_constant, rest_length);
+}
+
+// Remove a node; its edges are retired lazily by the generation check
+bool PazervilleDisplay::removeNode(PazervilleHandle handle) {
+    if (!isValidNode(handle)) {
+        return false;
+    }
+    
+    int idx = handle.index;
+    nodes[idx].active = false;
+    nodes[idx].generation++;
+    node_morph[idx].state = PAZERVILLE_MORPH_NONE;
+    node_morph[idx].froze = false;
+    impulse_x[idx] = 0.0f;
+    impulse_y[idx] = 0.0f;
+    node_next_free[idx] = node_free_head;
+    node_free_head = idx;
+    active_node_count--;
+    topology_revision++;
+    return true;
+}
+
+// Remove an edge
+bool PazervilleDisplay::removeEdge(PazervilleHandle handle) {
+    if (!isValidEdge(handle)) {
+        return false;
+    }
+    
+    releaseEdge(handle.index);
+    return true;
+}
+
+// Set how far an edge gives under the constraint solvers
+bool PazervilleDisplay::setEdgeCompliance(PazervilleHandle handle, float compliance) {
+    if (!isValidEdge(handle)) {
+        return false;
+    }
+    
+    edges[handle.index].compliance = compliance;
+    return true;
+}
+
+// Remove everything. Only the counts and free lists are reset; stale
+// slots are never visited because iteration stops at node_count and
+// edge_count, and reallocation bumps the slot generation.
+void PazervilleDisplay::clear() {
+    node_count = 0;
+    edge_count = 0;
+    active_node_count = 0;
+    active_edge_count = 0;
+    node_free_head = -1;
+    edge_free_head = -1;
+    has_impulses = false;
+    morph_steps = 0;
+    topology_revision++;
+}
+
+bool PazervilleDisplay::isValidNode(PazervilleHandle handle) const {
+    return handle.index >= 0 && handle.index < node_count &&
+           nodes[handle.index].active &&
+           nodes[handle.index].generation == handle.generation;
+}
+
+bool PazervilleDisplay::isValidEdge(PazervilleHandle handle) const {
+    return handle.index >= 0 && handle.index < edge_count &&
+           edges[handle.index].active &&
+           edges[handle.index].generation == handle.generation &&
+           edgeEndpointsValid(edges[handle.index]);
+}
+
+// Handle for the node currently in a slot
+PazervilleHandle PazervilleDisplay::getNodeHandle(int idx) const {
+    PazervilleHandle handle = { -1, 0 };
+    if (idx >= 0 && idx < node_count && nodes[idx].active) {
+        handle.index = idx;
+        handle.generation = nodes[idx].generation;
+    }
+    return handle;
+}
+
+// Replace the current graph with a precomputed layout.
+// Positions are already settled, so nodes start at rest.
+bool PazervilleDisplay::loadLayout(const PazervilleLayout &layout) {
+    if (layout.node_count > PAZERVILLE_MAX_NODES || layout.edge_count > PAZERVILLE_MAX_EDGES) {
+        return false;
+    }
+    
+    clear();
+    
+    // With the free lists empty, slots are handed out in table order
+    for (int i = 0; i < layout.node_count; i++) {
+        const PazervilleLayoutNode &src = layout.nodes[i];
+        addNode(src.x, src.y, src.mass, src.color, src.radius);
+    }
+    
+    for (int i = 0; i < layout.edge_count; i++) {
+        const PazervilleLayoutEdge &src = layout.edges[i];
+        PazervilleHandle edge = addEdge(src.node1, src.node2, src.spring_constant, src.rest_length);
+        if (edge.index >= 0) {
+            edges[edge.index].color = src.color;
+        }
+    }
+    
+    return true;
+}
+
+// Blend two RGB565 colours, t in 0.0 - 1.0
+static uint16_t lerpColor565(uint16_t from, uint16_t to, float t) {
+    int w = (int)(t * 32.0f + 0.5f);
+    int r = ((from >> 11) * (32 - w) + (to >> 11) * w) >> 5;
+    int g = (((from >> 5) & 0x3F) * (32 - w) + ((to >> 5) & 0x3F) * w) >> 5;
+    int b = ((from & 0x1F) * (32 - w) + (to & 0x1F) * w) >> 5;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// Start a transition to another graph. Live nodes are matched to target
+// nodes in slot order and stay where they are; extra target nodes fade in
+// at their settled positions and leftover nodes fade out. Edges joining
+// the same pair of nodes are kept; others fade their spring in or out.
+// Only the changed nodes and their neighbours are simulated meanwhile.
+bool PazervilleDisplay::morphTo(const PazervilleLayout &target, int steps) {
+    if (target.node_count > PAZERVILLE_MAX_NODES || target.edge_count > PAZERVILLE_MAX_EDGES) {
+        return false;
+    }
+    if (morph_steps > 0) {
+        finishMorph();
+    }
+    
+    // Match target nodes to live nodes in slot order; the rest are
+    // spawned below and get their slots then
+    int slot_of[PAZERVILLE_MAX_NODES];
+    int matched = 0;
+    for (int i = 0; i < node_count && matched < target.node_count; i++) {
+        if (nodes[i].active) slot_of[matched++] = i;
+    }
+    for (int i = matched; i < target.node_count; i++) {
+        slot_of[i] = -1;
+    }
+    
+    // Match current edges to target edges joining the same slots
+    bool target_found[PAZERVILLE_MAX_EDGES];
+    int edge_target[PAZERVILLE_MAX_EDGES];
+    for (int j = 0; j < target.edge_count; j++) {
+        target_found[j] = false;
+    }
+    for (int i = 0; i < edge_count; i++) {
+        edge_target[i] = -1;
+        if (!edges[i].active || !edgeEndpointsValid(edges[i])) continue;
+        
+        for (int j = 0; j < target.edge_count; j++) {
+            const PazervilleLayoutEdge &src = target.edges[j];
+            if (target_found[j]) continue;
+            if (src.node1 < 0 || src.node1 >= target.node_count ||
+                src.node2 < 0 || src.node2 >= target.node_count) continue;
+            
+            int a = slot_of[src.node1];
+            int b = slot_of[src.node2];
+            if (a < 0 || b < 0) continue;
+            if ((a == edges[i].node1 && b == edges[i].node2) ||
+                (a == edges[i].node2 && b == edges[i].node1)) {
+                target_found[j] = true;
+                edge_target[i] = j;
+                break;
+            }
+        }
+    }
+    
+    // Retiring edges hold their slots until the morph ends, so the new
+    // ones must fit beside them or the target cannot be reached
+    int new_edges = 0;
+    for (int j = 0; j < target.edge_count; j++) {
+        const PazervilleLayoutEdge &src = target.edges[j];
+        if (target_found[j]) continue;
+        if (src.node1 < 0 || src.node1 >= target.node_count ||
+            src.node2 < 0 || src.node2 >= target.node_count) continue;
+        new_edges++;
+    }
+    if (new_edges > PAZERVILLE_MAX_EDGES - active_edge_count) {
+        return loadLayout(target);
+    }
+    
+    // Matched nodes stay put and blend to their target look; the rest fade out
+    matched = 0;
+    for (int i = 0; i < node_count; i++) {
+        if (!nodes[i].active) continue;
+        
+        PazervilleMorphTrack &track = node_morph[i];
+        track.from_color = nodes[i].color;
+        track.from_size = nodes[i].radius;
+        
+        if (matched < target.node_count) {
+            const PazervilleLayoutNode &src = target.nodes[matched++];
+            nodes[i].mass = src.mass;
+            nodes[i].inv_mass = 1.0f / src.mass;
+            track.to_color = src.color;
+            track.to_size = src.radius;
+            bool changed = (src.color != nodes[i].color || src.radius != nodes[i].radius);
+            track.state = changed ? PAZERVILLE_MORPH_KEEP : PAZERVILLE_MORPH_NONE;
+        } else {
+            track.to_color = COLOR_BLACK;
+            track.to_size = 0.0f;
+            track.state = PAZERVILLE_MORPH_FADE_OUT;
+        }
+    }
+    
+    // Spawn the remaining target nodes at their settled positions
+    for (int i = matched; i < target.node_count; i++) {
+        const PazervilleLayoutNode &src = target.nodes[i];
+        PazervilleHandle handle = addNode(src.x, src.y, src.mass, COLOR_BLACK, 0);
+        slot_of[i] = handle.index;
+        
+        PazervilleMorphTrack &track = node_morph[handle.index];
+        track.state = PAZERVILLE_MORPH_FADE_IN;
+        track.from_color = COLOR_BLACK;
+        track.to_color = src.color;
+        track.from_size = 0.0f;
+        track.to_size = src.radius;
+    }
+    
+    // Matched edges blend to their target spring; the rest fade out
+    for (int i = 0; i < edge_count; i++) {
+        if (!edges[i].active || !edgeEndpointsValid(edges[i])) continue;
+        
+        PazervilleMorphTrack &track = edge_morph[i];
+        track.from_color = edges[i].color;
+        track.from_size = edges[i].spring_constant;
+        
+        if (edge_target[i] >= 0) {
+            const PazervilleLayoutEdge &src = target.edges[edge_target[i]];
+            edges[i].rest_length = src.rest_length;
+            track.to_color = src.color;
+            track.to_size = src.spring_constant;
+            bool changed = (src.color != edges[i].color || src.spring_constant != edges[i].spring_constant);
+            track.state = changed ? PAZERVILLE_MORPH_KEEP : PAZERVILLE_MORPH_NONE;
+        } else {
+            track.to_color = COLOR_BLACK;
+            track.to_size = 0.0f;
+            track.state = PAZERVILLE_MORPH_FADE_OUT;
+        }
+    }
+    
+    // Add the target edges that had no match, with zero stiffness
+    for (int j = 0; j < target.edge_count; j++) {
+        const PazervilleLayoutEdge &src = target.edges[j];
+        if (target_found[j]) continue;
+        if (src.node1 < 0 || src.node1 >= target.node_count ||
+            src.node2 < 0 || src.node2 >= target.node_count) continue;
+        
+        PazervilleHandle handle = addEdge(slot_of[src.node1], slot_of[src.node2], 0.0f, src.rest_length);
+        if (handle.index < 0) continue;
+        
+        edges[handle.index].color = COLOR_BLACK;
+        PazervilleMorphTrack &track = edge_morph[handle.index];
+        track.state = PAZERVILLE_MORPH_FADE_IN;
+        track.from_color = COLOR_BLACK;
+        track.to_color = src.color;
+        track.from_size = 0.0f;
+        track.to_size = src.spring_constant;
+    }
+    
+    // Affected set: changed nodes and endpoints of changed edges ...
+    bool changed[PAZERVILLE_MAX_NODES];
+    for (int i = 0; i < node_count; i++) {
+        changed[i] = nodes[i].active && node_morph[i].state != PAZERVILLE_MORPH_NONE;
+    }
+    for (int i = 0; i < edge_count; i++) {
+        if (edges[i].active && edge_morph[i].state != PAZERVILLE_MORPH_NONE) {
+            changed[edges[i].node1] = true;
+            changed[edges[i].node2] = true;
+        }
+    }
+    
+    // ... plus their direct neighbours
+    bool affected[PAZERVILLE_MAX_NODES];
+    for (int i = 0; i < node_count; i++) {
+        affected[i] = changed[i];
+    }
+    for (int i = 0; i < edge_count; i++) {
+        if (!edges[i].active || !edgeEndpointsValid(edges[i])) continue;
+        if (changed[edges[i].node1] || changed[edges[i].node2]) {
+            affected[edges[i].node1] = true;
+            affected[edges[i].node2] = true;
+        }
+    }
+    
+    // Everything else is frozen for the morph. Nodes that were already
+    // frozen, by the user or a drag, are left as they are and not recorded,
+    // so finishMorph() does not thaw them.
+    for (int i = 0; i < node_count; i++) {
+        if (!nodes[i].active) continue;
+        if (!affected[i] && !nodes[i].frozen) {
+            nodes[i].frozen = true;
+            node_morph[i].froze = true;
+        }
+        if (!nodes[i].frozen) wakeNode(i);
+    }
+    
+    morph_step = 0;
+    morph_steps = (steps < 1) ? 1 : steps;
+    return true;
+}
+
+// Move every morph track one step closer to its target
+void PazervilleDisplay::advanceMorph() {
+    morph_step++;
+    if (morph_step >= morph_steps) {
+        finishMorph();
         return;
     }
     
-    edges[edge_count].node1 = node1;
-    edges[edge_count].node2 = node2;
-    edges[edge_count].spring_constant = spring_constant;
-    edges[edge_count].rest_length = rest_length;
-    edges[edge_count].color = COLOR_GRAY;
-    edges[edge_count].active = true;
+    float t = (float)morph_step / morph_steps;
+    
+    for (int i = 0; i < node_count; i++) {
+        const PazervilleMorphTrack &track = node_morph[i];
+        if (track.state == PAZERVILLE_MORPH_NONE || !nodes[i].active) continue;
+        
+        nodes[i].color = lerpColor565(track.from_color, track.to_color, t);
+        nodes[i].radius = (uint8_t)(track.from_size + (track.to_size - track.from_size) * t + 0.5f);
+    }
+    
+    for (int i = 0; i < edge_count; i++) {
+        const PazervilleMorphTrack &track = edge_morph[i];
+        if (track.state == PAZERVILLE_MORPH_NONE || !edges[i].active) continue;
+        
+        edges[i].color = lerpColor565(track.from_color, track.to_color, t);
+        edges[i].spring_constant = track.from_size + (track.to_size - track.from_size) * t;
+    }
+}
+
+// Apply final values, drop retired elements and unfreeze the nodes the
+// morph froze
+void PazervilleDisplay::finishMorph() {
+    for (int i = 0; i < edge_count; i++) {
+        PazervilleMorphTrack &track = edge_morph[i];
+        if (track.state == PAZERVILLE_MORPH_NONE || !edges[i].active) continue;
+        
+        if (track.state == PAZERVILLE_MORPH_FADE_OUT) {
+            releaseEdge(i);
+        } else {
+            edges[i].color = track.to_color;
+            edges[i].spring_constant = track.to_size;
+        }
+        track.state = PAZERVILLE_MORPH_NONE;
+    }
+    
+    for (int i = 0; i < node_count; i++) {
+        PazervilleMorphTrack &track = node_morph[i];
+        if (track.froze) {
+            // A held node stays held; it thaws when it is let go
+            if (i == drag_node) {
+                drag_was_frozen = false;
+            } else {
+                nodes[i].frozen = false;
+            }
+            track.froze = false;
+        }
+        if (track.state == PAZERVILLE_MORPH_NONE || !nodes[i].active) continue;
+        
+        if (track.state == PAZERVILLE_MORPH_FADE_OUT) {
+            removeNode(getNodeHandle(i));
+        } else {
+            nodes[i].color = track.to_color;
+            nodes[i].radius = (uint8_t)track.to_size;
+        }
+        track.state = PAZERVILLE_MORPH_NONE;
+    }
     
-    edge_count++;
+    morph_steps = 0;
+    wakeAll();
 }
 
 // Update physics simulation
 void PazervilleDisplay::updateNodePhysics() {
+    if (active_set) {
+        wakeChangedFields();
+    }
+    
     // Apply spring forces
     applySpringForces();
     
-    // Apply gravity
+    // Nodes moving faster than the settle speed this step
+    uint8_t hot[PAZERVILLE_MAX_NODES];
+    bool any_hot = false;
+    int awake = 0;
+    float settle_sq = settle_speed * settle_speed;
+    if (active_set) {
+        for (int i = 0; i < node_count; i++) {
+            hot[i] = 0;
+        }
+    }
+    
+    // Single pass over the nodes: external forces, integration, damping
+    // and bounds, so each node is loaded and stored once per step
     for (int i = 0; i < node_count; i++) {
-        if (nodes[i].active) {
-            nodes[i].vy += gravity * time_step;
+        PazervilleNode &node = nodes[i];
+        if (!node.active) continue;
+        
+        // A held node drops anything pushed at it, so nothing fires late
+        if (node.frozen) {
+            node.vx = 0.0f;
+            node.vy = 0.0f;
+            impulse_x[i] = 0.0f;
+            impulse_y[i] = 0.0f;
+            continue;
+        }
+        
+        // A sleeping node has only collected spring pulls this step; it
+        // wakes if they would drive it faster than the settle speed. Steady
+        // fields and gravity are left out, since they are part of the
+        // balance it settled in; changes to them wake it before this pass.
+        if (node.asleep) {
+            float dv_sq = node.vx * node.vx + node.vy * node.vy;
+            float wake = settle_speed * (1.0f - damping);
+            node.vx = 0.0f;
+            node.vy = 0.0f;
+            if (dv_sq <= wake * wake) continue;
+            wakeNode(i);
+        }
+        
+        // Gravity, force fields and pending impulses
+        node.vy += gravity * time_step;
+        applyForceFields(node, i);
+        
+        // Update velocities and positions using Verlet integration
+        node.vx *= damping;
+        node.vy *= damping;
+        
+        node.x += node.vx * time_step;
+        node.y += node.vy * time_step;
+        
+        // Extra damping to reduce oscillation
+        node.vx *= 0.995f;
+        node.vy *= 0.995f;
+        
+        // Constrain node to screen
+        constrainNode(node);
+        
+        if (active_set) {
+            awake++;
+            if (node.vx * node.vx + node.vy * node.vy > settle_sq) {
+                node.calm_steps = 0;
+                hot[i] = 1;
+                any_hot = true;
+            } else if (++node.calm_steps >= PAZERVILLE_SETTLE_STEPS) {
+                node.asleep = true;
+                node.vx = 0.0f;
+                node.vy = 0.0f;
+            }
         }
     }
     
-    // Update velocities and positions using Verlet integration
+    if (collisions) {
+        resolveCollisions();
+    }
+    
+    if (active_set) {
+        awake_node_count = awake;
+        if (any_hot && settle_hops > 0) {
+            wakeNeighbourhoods(hot);
+        }
+    } else {
+        awake_node_count = active_node_count;
+    }
+    
+    has_impulses = false;
+}
+
+// Broad phase: sweep and prune on x. The order from the previous step is
+// nearly sorted, so insertion sort costs about one pass; pairs are only
+// tested while the next node starts before the current one ends.
+void PazervilleDisplay::resolveCollisions() {
+    // Drop removed nodes and append new ones
+    uint8_t listed[PAZERVILLE_MAX_NODES];
     for (int i = 0; i < node_count; i++) {
-        if (nodes[i].active) {
-            nodes[i].vx *= damping;
-            nodes[i].vy *= damping;
+        listed[i] = 0;
+    }
+    int kept = 0;
+    for (int i = 0; i < sweep_count; i++) {
+        uint8_t idx = sweep_order[i];
+        if (idx < node_count && nodes[idx].active) {
+            sweep_order[kept++] = idx;
+            listed[idx] = 1;
+        }
+    }
+    for (int i = 0; i < node_count; i++) {
+        if (nodes[i].active && !listed[i]) {
+            sweep_order[kept++] = i;
+        }
+    }
+    sweep_count = kept;
+    
+    for (int i = 1; i < sweep_count; i++) {
+        uint8_t idx = sweep_order[i];
+        float left = nodes[idx].x - nodes[idx].radius;
+        int j = i;
+        while (j > 0 && nodes[sweep_order[j - 1]].x - nodes[sweep_order[j - 1]].radius > left) {
+            sweep_order[j] = sweep_order[j - 1];
+            j--;
+        }
+        sweep_order[j] = idx;
+    }
+    
+    int pairs = 0;
+    for (int i = 0; i < sweep_count; i++) {
+        const PazervilleNode &a = nodes[sweep_order[i]];
+        float right = a.x + a.radius;
+        for (int j = i + 1; j < sweep_count; j++) {
+            const PazervilleNode &b = nodes[sweep_order[j]];
+            if (b.x - b.radius > right) break;
+            
+            float reach = a.radius + b.radius;
+            float dy = b.y - a.y;
+            if (dy > reach || dy < -reach) continue;
             
-            nodes[i].x += nodes[i].vx * time_step;
-            nodes[i].y += nodes[i].vy * time_step;
+            pairs++;
+            collideNodes(sweep_order[i], sweep_order[j]);
         }
     }
+    collision_pairs = pairs;
+}
+
+// Narrow phase: separate two overlapping nodes in proportion to their
+// inverse masses and cancel their closing speed with an impulse
+void PazervilleDisplay::collideNodes(int ia, int ib) {
+    PazervilleNode &a = nodes[ia];
+    PazervilleNode &b = nodes[ib];
+    
+    // Frozen nodes do not move; settled pairs cost nothing
+    float wa = a.frozen ? 0.0f : a.inv_mass;
+    float wb = b.frozen ? 0.0f : b.inv_mass;
+    if (wa + wb <= 0.0f) return;
+    if ((a.frozen || a.asleep) && (b.frozen || b.asleep)) return;
+    
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float dist_sq = dx * dx + dy * dy;
+    float reach = a.radius + b.radius;
+    if (dist_sq >= reach * reach) return;
+    
+    // Coincident centres: push apart along x
+    float nx = 1.0f;
+    float ny = 0.0f;
+    float dist = 0.0f;
+    if (dist_sq > 0.0001f) {
+        float inv_dist = pzInvSqrt(dist_sq);
+        nx = dx * inv_dist;
+        ny = dy * inv_dist;
+        dist = dist_sq * inv_dist;
+    }
+    
+    if (a.asleep) wakeNode(ia);
+    if (b.asleep) wakeNode(ib);
+    
+    float share = (reach - dist) / (wa + wb);
+    a.x -= nx * share * wa;
+    a.y -= ny * share * wa;
+    b.x += nx * share * wb;
+    b.y += ny * share * wb;
+    
+    // Only pairs still closing get an impulse
+    float closing = (b.vx - a.vx) * nx + (b.vy - a.vy) * ny;
+    if (closing < 0.0f) {
+        float j = -(1.0f + restitution) * closing / (wa + wb);
+        a.vx -= j * wa * nx;
+        a.vy -= j * wa * ny;
+        b.vx += j * wb * nx;
+        b.vy += j * wb * ny;
+    }
+    
+    constrainNode(a);
+    constrainNode(b);
+}
+
+// Extended position-based dynamics step. External forces move the
+// velocities, positions are predicted, every edge is projected back towards
+// its rest length, and the velocities are taken from the corrected
+// motion. The compliance term makes the result independent of the
+// iteration count and time step: 0 is rigid, 1 / k matches a spring of
+// stiffness k.
+void PazervilleDisplay::updateConstraintPhysics() {
+    float prev_x[PAZERVILLE_MAX_NODES];
+    float prev_y[PAZERVILLE_MAX_NODES];
+    float lambda[PAZERVILLE_MAX_EDGES];
+    float dt = time_step;
+    float inv_dt_sq = 1.0f / (dt * dt);
+    
+    for (int i = 0; i < node_count; i++) {
+        PazervilleNode &node = nodes[i];
+        if (!node.active) continue;
+        
+        node.asleep = false;
+        prev_x[i] = node.x;
+        prev_y[i] = node.y;
+        if (node.frozen) {
+            node.vx = 0.0f;
+            node.vy = 0.0f;
+            impulse_x[i] = 0.0f;
+            impulse_y[i] = 0.0f;
+            continue;
+        }
+        
+        node.vy += gravity * dt;
+        applyForceFields(node, i);
+        node.vx *= damping;
+        node.vy *= damping;
+        node.x += node.vx * dt;
+        node.y += node.vy * dt;
+    }
+    
+    for (int i = 0; i < edge_count; i++) {
+        lambda[i] = 0.0f;
+        if (edges[i].active && !edgeEndpointsValid(edges[i])) {
+            releaseEdge(i);
+        }
+    }
+    
+    // Jacobi passes collect every correction first and apply the average
+    // per node, so the result does not depend on edge order
+    bool jacobi = solver == PAZERVILLE_SOLVER_XPBD_JACOBI;
+    float move_x[PAZERVILLE_MAX_NODES];
+    float move_y[PAZERVILLE_MAX_NODES];
+    uint8_t moves[PAZERVILLE_MAX_NODES];
+    
+    for (int it = 0; it < solver_iterations; it++) {
+        if (jacobi) {
+            for (int i = 0; i < node_count; i++) {
+                move_x[i] = 0.0f;
+                move_y[i] = 0.0f;
+                moves[i] = 0;
+            }
+        }
+        
+        for (int i = 0; i < edge_count; i++) {
+            PazervilleEdge &edge = edges[i];
+            if (!edge.active) continue;
+            
+            PazervilleNode &n1 = nodes[edge.node1];
+            PazervilleNode &n2 = nodes[edge.node2];
+            float w1 = n1.frozen ? 0.0f : n1.inv_mass;
+            float w2 = n2.frozen ? 0.0f : n2.inv_mass;
+            
+            // Compliance follows the spring unless set; a spring at zero
+            // (or fading through it in a morph) is slack, not rigid
+            float compliance = edge.compliance;
+            if (compliance < 0.0f) {
+                if (edge.spring_constant <= 0.0f) continue;
+                compliance = 1.0f / edge.spring_constant;
+            }
+            float alpha = compliance * inv_dt_sq;
+            if (w1 + w2 + alpha <= 0.0f) continue;
+            
+            float dx = n2.x - n1.x;
+            float dy = n2.y - n1.y;
+            float dist_sq = dx * dx + dy * dy;
+            if (dist_sq < 0.0001f) continue;
+            
+            float inv_dist = pzInvSqrt(dist_sq);
+            float c = dist_sq * inv_dist - edge.rest_length;
+            float dl = (-c - alpha * lambda[i]) / (w1 + w2 + alpha);
+            lambda[i] += dl;
+            
+            // Along the edge: n1 moves by -w1 * dl, n2 by +w2 * dl
+            float px = dx * inv_dist * dl;
+            float py = dy * inv_dist * dl;
+            if (jacobi) {
+                move_x[edge.node1] -= px * w1;
+                move_y[edge.node1] -= py * w1;
+                move_x[edge.node2] += px * w2;
+                move_y[edge.node2] += py * w2;
+                moves[edge.node1]++;
+                moves[edge.node2]++;
+            } else {
+                n1.x -= px * w1;
+                n1.y -= py * w1;
+                n2.x += px * w2;
+                n2.y += py * w2;
+            }
+        }
+        
+        if (jacobi) {
+            for (int i = 0; i < node_count; i++) {
+                if (moves[i] == 0) continue;
+                
+                nodes[i].x += move_x[i] / moves[i];
+                nodes[i].y += move_y[i] / moves[i];
+            }
+        }
+    }
+    
+    // Velocities from the solved motion, then bounds
+    float inv_dt = 1.0f / dt;
+    for (int i = 0; i < node_count; i++) {
+        PazervilleNode &node = nodes[i];
+        if (!node.active || node.frozen) continue;
+        
+        node.vx = (node.x - prev_x[i]) * inv_dt * 0.995f;
+        node.vy = (node.y - prev_y[i]) * inv_dt * 0.995f;
+        constrainNode(node);
+    }
+    
+    if (collisions) {
+        resolveCollisions();
+    }
     
-    // Apply damping
-    applyDamping();
+    awake_node_count = active_node_count;
+    has_impulses = false;
+}
+
+// True if a field acts on a node at all, whatever its strength
+static bool fieldReaches(const PazervilleForceField &field, const PazervilleNode &node, int idx) {
+    if (!field.active) return false;
+    if (idx < field.first_node) return false;
+    if (field.last_node >= 0 && idx >= field.last_node) return false;
+    if (field.type == PAZERVILLE_FIELD_WIND || field.range <= 0.0f) return true;
+    
+    float dx = node.x - field.x;
+    float dy = node.y - field.y;
+    return dx * dx + dy * dy <= field.range * field.range;
+}
+
+// True if a field acts differently than it did at the last step
+static bool fieldChanged(const PazervilleForceField &now, const PazervilleForceField &seen) {
+    if (now.active != seen.active) return true;
+    if (!now.active) return false;
+    return now.type != seen.type || now.x != seen.x || now.y != seen.y ||
+           now.strength != seen.strength || now.range != seen.range ||
+           now.first_node != seen.first_node || now.last_node != seen.last_node ||
+           now.mass_scaled != seen.mass_scaled;
+}
+
+// Wake the sleeping nodes reached by a field that changed since the last
+// step, however it was changed: through the API, PAZERVILLE_CMD_SET_FIELD
+// or in place through getForceField(). A field that holds still does not
+// wake anything, so nodes can settle against it.
+void PazervilleDisplay::wakeChangedFields() {
+    for (int f = 0; f < PAZERVILLE_MAX_FIELDS; f++) {
+        PazervilleForceField now = fields[f];
+        if (f >= field_count) now.active = false;
+        if (!fieldChanged(now, field_seen[f])) continue;
+        
+        for (int i = 0; i < node_count; i++) {
+            const PazervilleNode &node = nodes[i];
+            if (!node.active || !node.asleep) continue;
+            if (fieldReaches(now, node, i) || fieldReaches(field_seen[f], node, i)) {
+                wakeNode(i);
+            }
+        }
+        field_seen[f] = now;
+    }
+}
+
+// Keep every node within settle_hops edges of a moving node awake
+void PazervilleDisplay::wakeNeighbourhoods(const uint8_t *hot) {
+    // reach[i] = hops from the nearest moving node, 0xFF if not reached
+    uint8_t reach[PAZERVILLE_MAX_NODES];
+    for (int i = 0; i < node_count; i++) {
+        reach[i] = hot[i] ? 0 : 0xFF;
+    }
     
-    // Constrain nodes to screen
-    constrainNodes();
+    for (int h = 0; h < settle_hops; h++) {
+        bool grew = false;
+        for (int i = 0; i < edge_count; i++) {
+            if (!edges[i].active || !edgeEndpointsValid(edges[i])) continue;
+            
+            int a = edges[i].node1;
+            int b = edges[i].node2;
+            if (reach[a] == h && reach[b] > h + 1) {
+                reach[b] = h + 1;
+                wakeNode(b);
+                grew = true;
+            }
+            if (reach[b] == h && reach[a] > h + 1) {
+                reach[a] = h + 1;
+                wakeNode(a);
+                grew = true;
+            }
+        }
+        if (!grew) break;
+    }
 }
 
 // Apply spring forces between connected nodes
@@ -108,66 +1028,123 @@ void PazervilleDisplay::applySpringForces() {
     for (int i = 0; i < edge_count; i++) {
         if (!edges[i].active) continue;
         
+        // Retire edges whose endpoint was removed
+        if (!edgeEndpointsValid(edges[i])) {
+            releaseEdge(i);
+            continue;
+        }
+        
         PazervilleNode &n1 = nodes[edges[i].node1];
         PazervilleNode &n2 = nodes[edges[i].node2];
         
-        if (!n1.active || !n2.active) continue;
+        // Settled regions cost nothing; a pull from one moving end is
+        // still collected so the sleeping end can decide to wake
+        if ((n1.frozen || n1.asleep) && (n2.frozen || n2.asleep)) continue;
         
         // Calculate distance between nodes
         float dx = n2.x - n1.x;
         float dy = n2.y - n1.y;
-        float dist = sqrt(dx * dx + dy * dy);
+        float dist_sq = dx * dx + dy * dy;
+        
+        if (dist_sq < 0.01f) continue;
         
-        if (dist < 0.1f) continue;
+        float inv_dist = pzInvSqrt(dist_sq);
+        float dist = dist_sq * inv_dist;
         
-        // Calculate spring force
+        // Calculate spring force, pre-scaled by the time step
         float force = edges[i].spring_constant * (dist - edges[i].rest_length);
-        float fx = (force * dx) / dist;
-        float fy = (force * dy) / dist;
+        float scale = force * inv_dist * time_step;
+        float fx = dx * scale;
+        float fy = dy * scale;
         
         // Apply force to nodes
-        n1.vx += (fx / n1.mass) * time_step;
-        n1.vy += (fy / n1.mass) * time_step;
-        n2.vx -= (fx / n2.mass) * time_step;
-        n2.vy -= (fy / n2.mass) * time_step;
-    }
-}
-
-// Apply damping to reduce oscillation
-void PazervilleDisplay::applyDamping() {
-    for (int i = 0; i < node_count; i++) {
-        if (nodes[i].active) {
-            nodes[i].vx *= 0.995f;
-            nodes[i].vy *= 0.995f;
-        }
+        n1.vx += fx * n1.inv_mass;
+        n1.vy += fy * n1.inv_mass;
+        n2.vx -= fx * n2.inv_mass;
+        n2.vy -= fy * n2.inv_mass;
     }
 }
 
-// Constrain nodes to stay within screen bounds with bounce
-void PazervilleDisplay::constrainNodes() {
-    for (int i = 0; i < node_count; i++) {
-        if (!nodes[i].active) continue;
+// Apply registered force fields and pending impulses to one node
+void PazervilleDisplay::applyForceFields(PazervilleNode &node, int idx) {
+    for (int f = 0; f < field_count; f++) {
+        const PazervilleForceField &field = fields[f];
+        if (!field.active) continue;
+        if (idx < field.first_node) continue;
+        if (field.last_node >= 0 && idx >= field.last_node) continue;
         
-        // Left and right bounds
-        if (nodes[i].x - nodes[i].radius < 0) {
-            nodes[i].x = nodes[i].radius;
-            nodes[i].vx *= -0.8f;  // Bounce with energy loss
-        }
-        if (nodes[i].x + nodes[i].radius > PAZERVILLE_WIDTH) {
-            nodes[i].x = PAZERVILLE_WIDTH - nodes[i].radius;
-            nodes[i].vx *= -0.8f;
+        float scale = field.strength * time_step;
+        if (field.mass_scaled) {
+            scale *= node.inv_mass;
         }
         
-        // Top and bottom bounds
-        if (nodes[i].y - nodes[i].radius < 0) {
-            nodes[i].y = nodes[i].radius;
-            nodes[i].vy *= -0.8f;
+        if (field.type == PAZERVILLE_FIELD_WIND) {
+            node.vx += field.x * scale;
+            node.vy += field.y * scale;
+            continue;
         }
-        if (nodes[i].y + nodes[i].radius > PAZERVILLE_HEIGHT) {
-            nodes[i].y = PAZERVILLE_HEIGHT - nodes[i].radius;
-            nodes[i].vy *= -0.8f;
+        
+        float dx = node.x - field.x;
+        float dy = node.y - field.y;
+        float dist_sq = dx * dx + dy * dy;
+        
+        if (dist_sq < 0.01f) continue;
+        if (field.range > 0.0f && dist_sq > field.range * field.range) continue;
+        
+        switch (field.type) {
+            case PAZERVILLE_FIELD_RADIAL: {
+                float inv_dist = pzInvSqrt(dist_sq);
+                node.vx += dx * inv_dist * scale;
+                node.vy += dy * inv_dist * scale;
+                break;
+            }
+            case PAZERVILLE_FIELD_ATTRACTOR: {
+                float inv_dist_sq = 1.0f / dist_sq;
+                node.vx -= dx * inv_dist_sq * scale;
+                node.vy -= dy * inv_dist_sq * scale;
+                break;
+            }
+            case PAZERVILLE_FIELD_VORTEX: {
+                float inv_dist = pzInvSqrt(dist_sq);
+                node.vx -= dy * inv_dist * scale;
+                node.vy += dx * inv_dist * scale;
+                break;
+            }
+            default:
+                break;
         }
     }
+    
+    if (has_impulses) {
+        float scale = node.inv_mass * time_step;
+        node.vx += impulse_x[idx] * scale;
+        node.vy += impulse_y[idx] * scale;
+        impulse_x[idx] = 0.0f;
+        impulse_y[idx] = 0.0f;
+    }
+}
+
+// Constrain a node to stay within screen bounds with bounce
+void PazervilleDisplay::constrainNode(PazervilleNode &node) {
+    // Left and right bounds
+    if (node.x - node.radius < 0) {
+        node.x = node.radius;
+        node.vx *= -0.8f;  // Bounce with energy loss
+    }
+    if (node.x + node.radius > PAZERVILLE_WIDTH) {
+        node.x = PAZERVILLE_WIDTH - node.radius;
+        node.vx *= -0.8f;
+    }
+    
+    // Top and bottom bounds
+    if (node.y - node.radius < 0) {
+        node.y = node.radius;
+        node.vy *= -0.8f;
+    }
+    if (node.y + node.radius > PAZERVILLE_HEIGHT) {
+        node.y = PAZERVILLE_HEIGHT - node.radius;
+        node.vy *= -0.8f;
+    }
 }
 
 // Draw a node on the display
@@ -178,48 +1155,279 @@ void PazervilleDisplay::drawNode(const PazervilleNode &node) {
     int y = (int)node.y;
     int r = node.radius;
     
-    display->drawCircle(x, y, r, node.color);
-    display->fillRect(x - r/2, y - r/2, r, r, node.color);
+    if (lod >= PAZERVILLE_LOD_POINT_NODES) {
+        display->drawPixel(x, y, node.color);
+        return;
+    }
+    
+    // Flat nodes: the classic centre square alone, every other style as
+    // a plain disc
+    PazervilleNodeStyle style = node_style;
+    if (lod >= PAZERVILLE_LOD_FLAT_NODES) {
+        if (style == PAZERVILLE_NODE_CLASSIC) {
+            display->fillRect(x - r/2, y - r/2, r, r, node.color);
+            return;
+        }
+        style = PAZERVILLE_NODE_DISC;
+    }
+    
+    const ILI9341Sprite *sprite = sprite_nodes ? sprites.get(r, node.color, style) : nullptr;
+    if (sprite) {
+        display->drawSprite(x - r, y - r, *sprite);
+        return;
+    }
+    
+    if (style == PAZERVILLE_NODE_CLASSIC) {
+        display->drawCircle(x, y, r, node.color);
+        display->fillRect(x - r/2, y - r/2, r, r, node.color);
+        return;
+    }
+    
+    // Disc styles without a cached image: one span per row, no edge effects
+    for (int dy = -r; dy <= r; dy++) {
+        int half = (int)pzSqrt((float)(r * r + r - dy * dy));
+        display->fillRect(x - half, y + dy, 2 * half + 1, 1, node.color);
+    }
 }
 
-// Draw an edge between two nodes
-void PazervilleDisplay::drawEdge(const PazervilleNode &n1, const PazervilleNode &n2, const PazervilleEdge &edge) {
-    if (!display) return;
+// Draw every valid edge, anti-aliased or in one batched scanline sweep
+void PazervilleDisplay::drawEdges() {
+    ILI9341Segment segments[PAZERVILLE_MAX_EDGES];
+    uint16_t count = 0;
+    bool cull = lod >= PAZERVILLE_LOD_CULL_EDGES;
     
-    int x1 = (int)n1.x;
-    int y1 = (int)n1.y;
-    int x2 = (int)n2.x;
-    int y2 = (int)n2.y;
+    for (int i = 0; i < edge_count; i++) {
+        const PazervilleEdge &edge = edges[i];
+        if (!edge.active || !edgeEndpointsValid(edge)) continue;
+        
+        ILI9341Segment &seg = segments[count];
+        seg.x0 = (int16_t)nodes[edge.node1].x;
+        seg.y0 = (int16_t)nodes[edge.node1].y;
+        seg.x1 = (int16_t)nodes[edge.node2].x;
+        seg.y1 = (int16_t)nodes[edge.node2].y;
+        seg.color = edge.color;
+        if (cull) {
+            int32_t dx = seg.x1 - seg.x0;
+            int32_t dy = seg.y1 - seg.y0;
+            if (dx * dx + dy * dy < PAZERVILLE_LOD_MIN_EDGE * PAZERVILLE_LOD_MIN_EDGE) continue;
+        }
+        count++;
+    }
+    
+    bool smooth = smooth_edges && lod < PAZERVILLE_LOD_NO_AA;
+    if (smooth && display->getColorMode() == ILI9341_COLOR_RGB565) {
+        for (uint16_t i = 0; i < count; i++) {
+            display->drawLineAA(segments[i].x0, segments[i].y0, segments[i].x1, segments[i].y1, segments[i].color);
+        }
+        return;
+    }
     
-    display->drawLine(x1, y1, x2, y2, edge.color);
+    display->drawLines(segments, count);
 }
 
 // Update the simulation
 void PazervilleDisplay::update() {
     if (!is_initialized) return;
     
-    updateNodePhysics();
+    applyCommands();
+    step();
+}
+
+// One physics step at the current time step
+void PazervilleDisplay::step() {
+    if (morph_steps > 0) {
+        advanceMorph();
+    }
+    
+    hit_grid_valid = false;
+    uint32_t start = micros();
+    if (solver == PAZERVILLE_SOLVER_SPRINGS) {
+        updateNodePhysics();
+    } else {
+        updateConstraintPhysics();
+    }
+    step_time_us += ((float)(micros() - start) - step_time_us) * 0.1f;
+}
+
+// Apply the commands posted so far. The batch is bounded by the ring
+// size, so a producer posting without pause cannot stall the frame;
+// anything it adds meanwhile waits for the next batch.
+void PazervilleDisplay::applyCommands() {
+    PazervilleCommand command;
+    int applied = 0;
+    while (applied < PAZERVILLE_COMMAND_SLOTS && commands.pop(&command)) {
+        applyCommand(command);
+        applied++;
+    }
+    commands_applied = applied;
+}
+
+// Carry out one posted command through the regular setters
+void PazervilleDisplay::applyCommand(const PazervilleCommand &command) {
+    switch (command.type) {
+        case PAZERVILLE_CMD_SET_DAMPING:
+            setDamping(command.value);
+            break;
+        case PAZERVILLE_CMD_SET_GRAVITY:
+            setGravity(command.value);
+            break;
+        case PAZERVILLE_CMD_SET_TIME_STEP:
+            setTimeStep(command.value);
+            break;
+        case PAZERVILLE_CMD_SET_FIELD: {
+            PazervilleForceField *field = getForceField(command.field.index);
+            if (field && field->active) {
+                field->strength = command.field.strength;
+                field->x = command.field.x;
+                field->y = command.field.y;
+            }
+            break;
+        }
+        case PAZERVILLE_CMD_IMPULSE:
+            if (isValidNode(command.force.node)) {
+                applyImpulse(command.force.node.index, command.force.fx, command.force.fy);
+            }
+            break;
+        case PAZERVILLE_CMD_REPEL:
+            if (isValidNode(command.force.node)) {
+                repelNode(command.force.node.index, command.force.fx, command.force.fy);
+            }
+            break;
+        case PAZERVILLE_CMD_ADD_NODE:
+            addNode(command.add_node.x, command.add_node.y, command.add_node.mass,
+                    command.add_node.color, command.add_node.radius);
+            break;
+        case PAZERVILLE_CMD_ADD_EDGE:
+            addEdge(command.add_edge.node1, command.add_edge.node2,
+                    command.add_edge.spring_constant, command.add_edge.rest_length);
+            break;
+        case PAZERVILLE_CMD_REMOVE_NODE:
+            removeNode(command.target);
+            break;
+        case PAZERVILLE_CMD_REMOVE_EDGE:
+            removeEdge(command.target);
+            break;
+    }
+}
+
+// Configure the physics governor
+void PazervilleDisplay::setPhysicsGovernor(uint8_t substeps, float share) {
+    physics_substeps = (substeps > 0) ? substeps : 1;
+    physics_share = share;
+    physics_credit_us = 0.0f;
+    physics_owed = 0.0f;
+    degraded_frames = 0;
+}
+
+// Advance the simulation by one frame's worth of steps, within the
+// governor's budget. The step cost is the smoothed time of update().
+void PazervilleDisplay::simulate() {
+    if (!is_initialized) return;
+    
+    // Posted changes land once, before the base step is read; the
+    // substeps below do not drain, so a time-step change is not
+    // overwritten when the stretched step is put back
+    applyCommands();
+    
+    uint8_t wanted = physics_substeps;
+    if (physics_share <= 0.0f) {
+        for (uint8_t i = 0; i < wanted; i++) {
+            step();
+        }
+        last_substeps = wanted;
+        physics_degraded = false;
+        return;
+    }
+    
+    // Unspent budget carries over, but only far enough to afford one step,
+    // so a slow frame cannot be followed by a burst
+    uint32_t period = frame_budget_us ? frame_budget_us : PAZERVILLE_PHYSICS_FRAME_US;
+    float budget = physics_share * (float)period;
+    float cap = (step_time_us > budget) ? step_time_us : budget;
+    physics_credit_us += budget;
+    if (physics_credit_us > cap) physics_credit_us = cap;
+    
+    // Simulated time owed to real time, bounded by what stretched steps
+    // can catch up; beyond that the simulation slows down
+    float dt = time_step;
+    float max_owed = wanted * dt * PAZERVILLE_PHYSICS_MAX_STRETCH;
+    physics_owed += wanted * dt;
+    if (physics_owed > max_owed) physics_owed = max_owed;
+    
+    uint8_t steps = wanted;
+    if (step_time_us > 0.0f) {
+        float affordable = physics_credit_us / step_time_us;
+        if (affordable < steps) steps = (uint8_t)affordable;
+    }
+    
+    last_substeps = steps;
+    physics_degraded = steps < wanted;
+    if (physics_degraded) {
+        degraded_frames++;
+    }
+    if (steps == 0) return;
+    
+    float step_dt = physics_owed / steps;
+    if (step_dt > dt * PAZERVILLE_PHYSICS_MAX_STRETCH) {
+        step_dt = dt * PAZERVILLE_PHYSICS_MAX_STRETCH;
+    }
+    physics_owed -= step_dt * steps;
+    
+    uint32_t start = micros();
+    time_step = step_dt;
+    for (uint8_t i = 0; i < steps; i++) {
+        step();
+    }
+    time_step = dt;
+    physics_credit_us -= (float)(micros() - start);
 }
 
 // Draw the Pazerville graph
 void PazervilleDisplay::draw() {
     if (!is_initialized || !display) return;
     
-    // Clear screen
-    display->fillScreen(COLOR_BLACK);
+    // Frame rate, smoothed over roughly ten frames
+    uint32_t now = micros();
+    if (last_draw_us != 0 && now != last_draw_us) {
+        float rate = 1000000.0f / (float)(now - last_draw_us);
+        fps = (fps == 0.0f) ? rate : fps + (rate - fps) * 0.1f;
+    }
+    last_draw_us = now;
     
-    // Draw edges
-    for (int i = 0; i < edge_count; i++) {
-        if (!edges[i].active) continue;
-        
-        PazervilleNode &n1 = nodes[edges[i].node1];
-        PazervilleNode &n2 = nodes[edges[i].node2];
-        
-        if (n1.active && n2.active) {
-            drawEdge(n1, n2, edges[i]);
+    // At the lowest detail the previous frame is simply shown again
+    frame_count++;
+    if (lod >= PAZERVILLE_LOD_HALF_RATE && (frame_count & 1)) {
+        return;
+    }
+    
+    // Large graphs trade resolution for fill rate. If the display was
+    // initialized at half resolution the switch up simply fails.
+    bool resized = false;
+    if (auto_resolution) {
+        bool large = active_node_count >= half_res_nodes || active_edge_count >= half_res_edges;
+        ILI9341Resolution wanted = large ? ILI9341_RES_HALF : ILI9341_RES_FULL;
+        if (display->getResolution() != wanted && display->setResolution(wanted)) {
+            hud.invalidate();
+            resized = true;
         }
     }
     
+    // Clear or fade the screen. With the HUD on the graph owns only the
+    // rows below it, so unchanged HUD cells stay clean. A resize leaves
+    // the framebuffer meaningless, so trails restart from black.
+    uint16_t top = hud_enabled ? hud.getBottom() : 0;
+    if (top > 0) {
+        display->setClipRect(0, top, PAZERVILLE_WIDTH, PAZERVILLE_HEIGHT - top);
+    }
+    if (trails && !resized && display->getColorMode() == ILI9341_COLOR_RGB565) {
+        display->fadeScreen(trail_keep);
+    } else {
+        display->fillScreen(COLOR_BLACK);
+    }
+    
+    // Draw edges
+    drawEdges();
+    
     // Draw nodes
     for (int i = 0; i < node_count; i++) {
         if (nodes[i].active) {
@@ -227,8 +1435,108 @@ void PazervilleDisplay::draw() {
         }
     }
     
+    // Overlay after the graph pass; it is allowed to lag a frame
+    if (top > 0) {
+        display->clearClipRect();
+        if (lod < PAZERVILLE_LOD_NO_AA || !(frame_count & 1)) {
+            updateHUD();
+        }
+    }
+    
     // Update display
+    uint32_t flush_start = micros();
     display->updateDisplay();
+    uint32_t end = micros();
+    
+    if (touch_pending) {
+        last_touch_latency_us = (float)(end - touch_sample_us);
+        touch_latency_us = (touch_latency_us == 0.0f) ? last_touch_latency_us
+            : touch_latency_us + (last_touch_latency_us - touch_latency_us) * 0.1f;
+        touch_pending = false;
+    }
+    
+    raster_time_us += ((float)(flush_start - now) - raster_time_us) * 0.1f;
+    flush_time_us += ((float)(end - flush_start) - flush_time_us) * 0.1f;
+    updateLOD(end - now);
+}
+
+// Set the frame-time budget; 0 disables the controller
+void PazervilleDisplay::setFrameBudget(uint32_t us) {
+    frame_budget_us = us;
+    lod = PAZERVILLE_LOD_FULL;
+    lod_over = 0;
+    lod_under = 0;
+    frame_cost_us = 0.0f;
+}
+
+// Move the detail level one step at a time. Dropping detail reacts within
+// a few frames; restoring it needs a long run of frames with clear
+// headroom, since the next level up can cost nearly twice as much.
+void PazervilleDisplay::updateLOD(uint32_t cost_us) {
+    if (frame_budget_us == 0) return;
+    
+    // A fresh level starts its own average
+    frame_cost_us = (frame_cost_us == 0.0f) ? (float)cost_us : frame_cost_us + ((float)cost_us - frame_cost_us) * 0.2f;
+    
+    // At half rate a draw() call costs half a frame on average
+    float load = frame_cost_us;
+    if (lod >= PAZERVILLE_LOD_HALF_RATE) {
+        load *= 0.5f;
+    }
+    
+    if (load > (float)frame_budget_us) {
+        lod_under = 0;
+        if (++lod_over >= PAZERVILLE_LOD_RAISE_FRAMES && lod < PAZERVILLE_LOD_HALF_RATE) {
+            lod = (PazervilleLOD)(lod + 1);
+            lod_over = 0;
+            frame_cost_us = 0.0f;
+        }
+    } else if (load < (float)frame_budget_us * PAZERVILLE_LOD_HEADROOM) {
+        lod_over = 0;
+        if (++lod_under >= PAZERVILLE_LOD_LOWER_FRAMES && lod > PAZERVILLE_LOD_FULL) {
+            lod = (PazervilleLOD)(lod - 1);
+            lod_under = 0;
+            frame_cost_us = 0.0f;
+        }
+    } else {
+        lod_over = 0;
+        lod_under = 0;
+    }
+}
+
+// Enable or disable the statistics overlay
+void PazervilleDisplay::setHUD(bool enabled) {
+    hud_enabled = enabled;
+    hud.clearFields();
+    if (!enabled) return;
+    
+    hud_fields[0] = hud.addField("FPS ", 2, 0);
+    hud_fields[1] = hud.addField("STEP ", 62, 0);
+    hud_fields[2] = hud.addField("N ", 134, 0);
+    hud_fields[3] = hud.addField("E ", 164, 0);
+    hud_fields[4] = hud.addField("KE ", 194, 0);
+}
+
+// Refresh the overlay values and draw the cells that changed
+void PazervilleDisplay::updateHUD() {
+    hud.setFixed(hud_fields[0], fps, 1);
+    hud.setInt(hud_fields[1], (int32_t)step_time_us, "us");
+    hud.setInt(hud_fields[2], active_node_count);
+    hud.setInt(hud_fields[3], active_edge_count);
+    hud.setFixed(hud_fields[4], getKineticEnergy(), 1);
+    hud.render();
+}
+
+// Total kinetic energy of the active nodes
+float PazervilleDisplay::getKineticEnergy() const {
+    float energy = 0.0f;
+    for (int i = 0; i < node_count; i++) {
+        const PazervilleNode &n = nodes[i];
+        if (n.active) {
+            energy += 0.5f * n.mass * (n.vx * n.vx + n.vy * n.vy);
+        }
+    }
+    return energy;
 }
 
 // Repel a node with a force
@@ -236,8 +1544,10 @@ void PazervilleDisplay::repelNode(int node_id, float force_x, float force_y) {
     if (node_id < 0 || node_id >= node_count) return;
     if (!nodes[node_id].active) return;
     
-    nodes[node_id].vx += (force_x / nodes[node_id].mass) * time_step;
-    nodes[node_id].vy += (force_y / nodes[node_id].mass) * time_step;
+    wakeNode(node_id);
+    float scale = nodes[node_id].inv_mass * time_step;
+    nodes[node_id].vx += force_x * scale;
+    nodes[node_id].vy += force_y * scale;
 }
 
 // Attract a node to a point
@@ -247,12 +1557,15 @@ void PazervilleDisplay::attractToPoint(int node_id, float target_x, float target
     
     float dx = target_x - nodes[node_id].x;
     float dy = target_y - nodes[node_id].y;
-    float dist = sqrt(dx * dx + dy * dy);
+    float dist_sq = dx * dx + dy * dy;
     
-    if (dist > 0.1f) {
-        float force = strength / dist;
-        nodes[node_id].vx += (force * dx / dist) * time_step;
-        nodes[node_id].vy += (force * dy / dist) * time_step;
+    if (dist_sq > 0.01f) {
+        wakeNode(node_id);
+        
+        // strength / dist along the unit vector: strength * d / dist^2
+        float scale = strength / dist_sq * time_step;
+        nodes[node_id].vx += dx * scale;
+        nodes[node_id].vy += dy * scale;
     }
 }
 
@@ -264,8 +1577,10 @@ void PazervilleDisplay::randomizePositions() {
             nodes[i].y = 20 + (rand() % (PAZERVILLE_HEIGHT - 40));
             nodes[i].vx = (rand() % 100 - 50) * 0.01f;
             nodes[i].vy = (rand() % 100 - 50) * 0.01f;
+            wakeNode(i);
         }
     }
+    hit_grid_valid = false;
 }
 
 // Reset simulation to initial state
@@ -275,3 +1590,265 @@ void PazervilleDisplay::resetSimulation() {
         nodes[i].vy = 0.0f;
     }
 }
+
+// Bucket the active nodes by the grid cell of their centre
+void PazervilleDisplay::buildHitGrid() {
+    for (int i = 0; i < PAZERVILLE_HIT_COLUMNS * PAZERVILLE_HIT_ROWS; i++) {
+        hit_head[i] = -1;
+    }
+    
+    hit_reach = 0;
+    for (int i = 0; i < node_count; i++) {
+        const PazervilleNode &node = nodes[i];
+        if (!node.active) continue;
+        
+        int cx = (int)node.x / PAZERVILLE_HIT_CELL;
+        int cy = (int)node.y / PAZERVILLE_HIT_CELL;
+        cx = (cx < 0) ? 0 : (cx >= PAZERVILLE_HIT_COLUMNS) ? PAZERVILLE_HIT_COLUMNS - 1 : cx;
+        cy = (cy < 0) ? 0 : (cy >= PAZERVILLE_HIT_ROWS) ? PAZERVILLE_HIT_ROWS - 1 : cy;
+        
+        int cell = cy * PAZERVILLE_HIT_COLUMNS + cx;
+        hit_next[i] = hit_head[cell];
+        hit_head[cell] = i;
+        if (node.radius > hit_reach) hit_reach = node.radius;
+    }
+    
+    hit_grid_valid = true;
+    hit_grid_revision = topology_revision;
+}
+
+// Nearest node within its radius plus 'slop' of (x, y), or -1
+int PazervilleDisplay::findNodeAt(float x, float y, float slop) {
+    if (!hit_grid_valid || hit_grid_revision != topology_revision) {
+        buildHitGrid();
+    }
+    
+    // Cells whose nodes could reach the point
+    float reach = hit_reach + slop;
+    int cx0 = (int)(x - reach) / PAZERVILLE_HIT_CELL;
+    int cx1 = (int)(x + reach) / PAZERVILLE_HIT_CELL;
+    int cy0 = (int)(y - reach) / PAZERVILLE_HIT_CELL;
+    int cy1 = (int)(y + reach) / PAZERVILLE_HIT_CELL;
+    if (cx0 < 0) cx0 = 0;
+    if (cy0 < 0) cy0 = 0;
+    if (cx1 >= PAZERVILLE_HIT_COLUMNS) cx1 = PAZERVILLE_HIT_COLUMNS - 1;
+    if (cy1 >= PAZERVILLE_HIT_ROWS) cy1 = PAZERVILLE_HIT_ROWS - 1;
+    
+    int best = -1;
+    float best_sq = 0.0f;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            for (int i = hit_head[cy * PAZERVILLE_HIT_COLUMNS + cx]; i >= 0; i = hit_next[i]) {
+                const PazervilleNode &node = nodes[i];
+                float dx = node.x - x;
+                float dy = node.y - y;
+                float d_sq = dx * dx + dy * dy;
+                float r = node.radius + slop;
+                if (d_sq <= r * r && (best < 0 || d_sq < best_sq)) {
+                    best = i;
+                    best_sq = d_sq;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// Take hold of a node; any node already held is dropped first
+bool PazervilleDisplay::beginDrag(int node_id) {
+    if (node_id < 0 || node_id >= node_count) return false;
+    if (!nodes[node_id].active) return false;
+    
+    if (drag_node >= 0) {
+        endDrag();
+    }
+    
+    PazervilleNode &node = nodes[node_id];
+    drag_node = node_id;
+    drag_generation = node.generation;
+    drag_was_frozen = node.frozen;
+    drag_vx = 0.0f;
+    drag_vy = 0.0f;
+    drag_time_us = 0;
+    node.frozen = true;
+    node.vx = 0.0f;
+    node.vy = 0.0f;
+    return true;
+}
+
+// Move the held node to the pointer
+void PazervilleDisplay::dragTo(float x, float y, uint32_t time_us) {
+    if (drag_node < 0) return;
+    
+    PazervilleNode &node = nodes[drag_node];
+    if (!node.active || node.generation != drag_generation) {
+        drag_node = -1;  // removed while held
+        return;
+    }
+    
+    // Pointer velocity in the units of node.vx, for the release
+    if (drag_time_us != 0 && time_us != drag_time_us) {
+        float dt = (float)(time_us - drag_time_us) * 0.000001f;
+        drag_vx += ((x - node.x) / dt - drag_vx) * 0.5f;
+        drag_vy += ((y - node.y) / dt - drag_vy) * 0.5f;
+    }
+    drag_time_us = time_us;
+    
+    // Held even if something unfroze it meanwhile
+    node.frozen = true;
+    node.x = x;
+    node.y = y;
+    constrainNode(node);
+    hit_grid_valid = false;
+    
+    // Neighbours follow the pointer, so they must not sleep through it
+    wakeNode(drag_node);
+    for (int i = 0; i < edge_count; i++) {
+        const PazervilleEdge &edge = edges[i];
+        if (!edge.active) continue;
+        if (edge.node1 == drag_node) wakeNode(edge.node2);
+        if (edge.node2 == drag_node) wakeNode(edge.node1);
+    }
+}
+
+// Let go of the held node
+void PazervilleDisplay::endDrag() {
+    if (drag_node < 0) return;
+    
+    PazervilleNode &node = nodes[drag_node];
+    if (node.active && node.generation == drag_generation) {
+        node.frozen = drag_was_frozen;
+        if (!node.frozen) {
+            node.vx = drag_vx;
+            node.vy = drag_vy;
+        }
+        wakeNode(drag_node);
+    }
+    drag_node = -1;
+}
+
+// Pick up, move or drop a node from a touch point
+bool PazervilleDisplay::handleTouch(const PazervilleTouchPoint &point) {
+    if (!point.down) {
+        touch_held = false;
+        endDrag();
+        return false;
+    }
+    
+    // Only a fresh press picks a node; sliding onto one does not
+    if (!touch_held) {
+        touch_held = true;
+        int idx = findNodeAt(point.x, point.y);
+        if (idx >= 0) {
+            beginDrag(idx);
+        }
+    }
+    if (drag_node < 0) return false;
+    
+    dragTo(point.x, point.y, point.time_us);
+    touch_pending = true;
+    touch_sample_us = point.time_us;
+    return drag_node >= 0;
+}
+
+// Register a force field; returns its index or -1 if the table is full
+int PazervilleDisplay::addForceField(PazervilleFieldType type, float x, float y, float strength) {
+    int idx = -1;
+    for (int i = 0; i < field_count; i++) {
+        if (!fields[i].active) {
+            idx = i;
+            break;
+        }
+    }
+    if (idx < 0) {
+        if (field_count >= PAZERVILLE_MAX_FIELDS) {
+            return -1;
+        }
+        idx = field_count++;
+    }
+    
+    fields[idx].type = type;
+    fields[idx].x = x;
+    fields[idx].y = y;
+    fields[idx].strength = strength;
+    fields[idx].range = 0.0f;
+    fields[idx].first_node = 0;
+    fields[idx].last_node = -1;
+    fields[idx].mass_scaled = false;
+    fields[idx].active = true;
+    wakeAll();
+    
+    return idx;
+}
+
+// Remove a force field
+void PazervilleDisplay::removeForceField(int idx) {
+    if (idx < 0 || idx >= field_count) return;
+    
+    fields[idx].active = false;
+    wakeAll();
+    while (field_count > 0 && !fields[field_count - 1].active) {
+        field_count--;
+    }
+}
+
+// Remove all force fields
+void PazervilleDisplay::clearForceFields() {
+    for (int i = 0; i < field_count; i++) {
+        fields[i].active = false;
+    }
+    field_count = 0;
+    wakeAll();
+}
+
+// Queue a force for the next step; repeated calls accumulate
+void PazervilleDisplay::applyImpulse(int node_id, float force_x, float force_y) {
+    if (node_id < 0 || node_id >= node_count) return;
+    if (!nodes[node_id].active) return;
+    
+    impulse_x[node_id] += force_x;
+    impulse_y[node_id] += force_y;
+    has_impulses = true;
+    wakeNode(node_id);
+}
+
+// Enable or disable active-set scheduling
+void PazervilleDisplay::setActiveSet(bool enabled, float speed, int hops) {
+    active_set = enabled;
+    settle_speed = speed;
+    settle_hops = hops;
+    wakeAll();
+}
+
+// Choose how edges act on their nodes
+void PazervilleDisplay::setSolver(PazervilleSolver mode, int iterations) {
+    solver = mode;
+    solver_iterations = (iterations > 0) ? iterations : 1;
+    wakeAll();
+}
+
+// Enable or disable node-node collisions
+void PazervilleDisplay::setCollisions(bool enabled, float r) {
+    collisions = enabled;
+    restitution = r;
+    sweep_count = 0;
+    collision_pairs = 0;
+}
+
+// Enable or disable graph-size driven resolution switching
+void PazervilleDisplay::setAutoResolution(bool enabled, int nodes, int edges) {
+    auto_resolution = enabled;
+    half_res_nodes = nodes;
+    half_res_edges = edges;
+    
+    if (!enabled && display) {
+        display->setResolution(ILI9341_RES_FULL);
+    }
+}
+
+// Wake every node, e.g. after moving a force field or changing parameters
+void PazervilleDisplay::wakeAll() {
+    for (int i = 0; i < node_count; i++) {
+        wakeNode(i);
+    }
+}
@@ -8,6 +8,9 @@
 #include "include/ili9341_display.h"
 #include "include/pazerville_display.h"
 #include "include/pazerville_examples.h"
+#include "include/pazerville_baked_layouts.h"
+#include "include/pazerville_audio.h"
+#include "include/pazerville_cv.h"
 
 // ============================================================================
 // EXAMPLE 1: Interactive Network with Real-Time Control
@@ -30,18 +33,21 @@ void example_interactive_network() {
     uint32_t last_interaction = 0;
     float angle = 0.0f;
     
+    // Rotating attractor for the outer nodes (the hub is the last node)
+    int orbit_field = pazerville.addForceField(PAZERVILLE_FIELD_ATTRACTOR,
+                                               PAZERVILLE_WIDTH/2, PAZERVILLE_HEIGHT/2, 30.0f);
+    pazerville.getForceField(orbit_field)->last_node = pazerville.getNodeCount() - 1;
+    
     while (1) {
         // Update physics
         pazerville.update();
         pazerville.draw();
         
-        // Add rotating attractors
+        // Move the rotating attractor
         angle += 0.05f;
-        for (int i = 0; i < pazerville.getNodeCount() - 1; i++) {
-            float target_x = PAZERVILLE_WIDTH/2 + 40*cos(angle);
-            float target_y = PAZERVILLE_HEIGHT/2 + 40*sin(angle);
-            pazerville.attractToPoint(i, target_x, target_y, 30.0f);
-        }
+        PazervilleForceField *orbit = pazerville.getForceField(orbit_field);
+        orbit->x = PAZERVILLE_WIDTH/2 + 40*pzCos(angle);
+        orbit->y = PAZERVILLE_HEIGHT/2 + 40*pzSin(angle);
         
         // Check for serial commands
         if (Serial.available()) {
@@ -83,8 +89,7 @@ void example_topology_transitions() {
         if (transition_timer > 500) {  // 500 * 10ms = 5 seconds
             topology_index = (topology_index + 1) % 5;
             
-            // Smoothly transition by resetting
-            pazerville.resetSimulation();
+            // Morph in place; unchanged nodes keep their positions
             switchTopology(&pazerville, topology_index);
             
             transition_timer = 0;
@@ -111,42 +116,30 @@ void example_cv_driven_physics() {
     PazervilleExamples::createGridNetwork(&pazerville, 3, 3);
     pazerville.setDamping(0.88f);
     
-    // Analog inputs for CV (assuming connected to A0, A1, A2)
-    int cv_damping_pin = A0;
-    int cv_gravity_pin = A1;
-    int cv_repel_pin = A2;
+    // CV inputs on A0, A1, A2, sampled and filtered in the background and
+    // mapped straight to physics parameters
+    static PazervilleCV cv;
+    int cv_damping = cv.addChannel(A0, 0.80f, 0.95f);
+    int cv_gravity = cv.addChannel(A1, 0.0f, 1.0f, PAZERVILLE_CURVE_EXPONENTIAL);
+    int cv_repel = cv.addChannel(A2, 0.0f, 200.0f);
+    cv.begin();
+    
+    // Radial push from the center, strength set from CV every frame
+    int repel_field = pazerville.addForceField(PAZERVILLE_FIELD_RADIAL,
+                                               PAZERVILLE_WIDTH / 2.0f, PAZERVILLE_HEIGHT / 2.0f, 0.0f);
+    pazerville.getForceField(repel_field)->mass_scaled = true;
     
     while (1) {
-        // Read analog inputs (0-1023)
-        int cv_damping = analogRead(cv_damping_pin);
-        int cv_gravity = analogRead(cv_gravity_pin);
-        int cv_repel = analogRead(cv_repel_pin);
-        
-        // Map to physics parameters
-        float damping = 0.80f + (cv_damping / 1023.0f) * 0.15f;  // 0.80 - 0.95
-        float gravity = (cv_gravity / 1023.0f) * 1.0f;            // 0.0 - 1.0
-        float repel_strength = (cv_repel / 1023.0f) * 200.0f;    // 0 - 200
+        // Zero-wait reads of the latest filtered values
+        float damping = cv.read(cv_damping);        // 0.80 - 0.95
+        float gravity = cv.read(cv_gravity);        // 0.0 - 1.0
+        float repel_strength = cv.read(cv_repel);   // 0 - 200
         
         pazerville.setDamping(damping);
         pazerville.setGravity(gravity);
         
-        // Apply repulsion from center based on CV
-        float center_x = PAZERVILLE_WIDTH / 2.0f;
-        float center_y = PAZERVILLE_HEIGHT / 2.0f;
-        
-        for (int i = 0; i < pazerville.getNodeCount(); i++) {
-            PazervilleNode *node = pazerville.getNode(i);
-            if (node) {
-                float dx = node->x - center_x;
-                float dy = node->y - center_y;
-                float dist = sqrt(dx*dx + dy*dy);
-                if (dist > 0.1f) {
-                    pazerville.repelNode(i, 
-                        (dx/dist) * repel_strength * 0.001f,
-                        (dy/dist) * repel_strength * 0.001f);
-                }
-            }
-        }
+        // Repulsion from center based on CV
+        pazerville.getForceField(repel_field)->strength = repel_strength * 0.001f;
         
         pazerville.update();
         pazerville.draw();
@@ -171,24 +164,34 @@ void example_music_visualization() {
     pazerville.setDamping(0.85f);
     pazerville.setGravity(0.0f);
     
-    // Audio input would come from ADC or FFT processor
-    // For this example, we'll simulate with sine waves
+    // Line-level audio (biased to mid-rail) on A3, analysed in the background
+    static PazervilleAudio audio;
+    audio.begin(A3);
+    
+    // One attractor per frequency band, each pulling its own node inward
+    float center_x = PAZERVILLE_WIDTH / 2.0f;
+    float center_y = PAZERVILLE_HEIGHT / 2.0f;
+    int band_field[PAZERVILLE_AUDIO_BANDS];
+    for (int i = 0; i < PAZERVILLE_AUDIO_BANDS; i++) {
+        band_field[i] = pazerville.addForceField(PAZERVILLE_FIELD_ATTRACTOR, center_x, center_y, 0.0f);
+        PazervilleForceField *field = pazerville.getForceField(band_field[i]);
+        if (field) {
+            field->first_node = i;
+            field->last_node = i + 1;
+        }
+    }
     
-    float time = 0.0f;
+    PazervilleAudioFrame frame;
     
     while (1) {
-        time += 0.016f;
-        
-        // Simulate frequency bands (8 frequency bins)
-        for (int i = 0; i < 8; i++) {
-            float freq = 100.0f + i * 150.0f;  // 100Hz, 250Hz, 400Hz, etc.
-            float magnitude = (sin(time * freq) + 1.0f) / 2.0f * 100.0f;
-            
-            // Attract node inward based on frequency magnitude
-            float center_x = PAZERVILLE_WIDTH / 2.0f;
-            float center_y = PAZERVILLE_HEIGHT / 2.0f;
-            
-            pazerville.attractToPoint(i, center_x, center_y, magnitude);
+        // Analyse the newest captured block, if any; never waits on audio
+        if (audio.read(&frame)) {
+            for (int i = 0; i < PAZERVILLE_AUDIO_BANDS; i++) {
+                PazervilleForceField *field = pazerville.getForceField(band_field[i]);
+                if (field) {
+                    field->strength = frame.band[i] * 100.0f;
+                }
+            }
         }
         
         pazerville.update();
@@ -216,8 +219,8 @@ void example_particle_burst() {
     int num_particles = 6;
     for (int i = 0; i < num_particles; i++) {
         float angle = (2.0f * PI * i) / num_particles;
-        float x = PAZERVILLE_WIDTH/2 + 20*cos(angle);
-        float y = PAZERVILLE_HEIGHT/2 + 20*sin(angle);
+        float x = PAZERVILLE_WIDTH/2 + 20*pzCos(angle);
+        float y = PAZERVILLE_HEIGHT/2 + 20*pzSin(angle);
         pazerville.addNode(x, y, 1.0f, getColorFromFreq(i), 3);
         
         // Connect to center
@@ -226,26 +229,20 @@ void example_particle_burst() {
     
     pazerville.setDamping(0.90f);
     
+    // Radial burst field acting on the particles only (not the center node)
+    int burst_field = pazerville.addForceField(PAZERVILLE_FIELD_RADIAL,
+                                               PAZERVILLE_WIDTH/2, PAZERVILLE_HEIGHT/2, 0.0f);
+    PazervilleForceField *burst = pazerville.getForceField(burst_field);
+    burst->first_node = 1;
+    burst->mass_scaled = true;
+    
     uint32_t burst_time = millis();
     
     while (1) {
         uint32_t elapsed = millis() - burst_time;
         
-        // Every 2 seconds, create a burst
-        if (elapsed % 2000 < 100) {
-            // Repel all particles
-            for (int i = 1; i <= num_particles; i++) {
-                PazervilleNode *node = pazerville.getNode(i);
-                if (node) {
-                    float dx = node->x - PAZERVILLE_WIDTH/2;
-                    float dy = node->y - PAZERVILLE_HEIGHT/2;
-                    float dist = sqrt(dx*dx + dy*dy);
-                    if (dist > 0.1f) {
-                        pazerville.repelNode(i, (dx/dist)*200, (dy/dist)*200);
-                    }
-                }
-            }
-        }
+        // Every 2 seconds, create a burst that repels all particles
+        burst->strength = (elapsed % 2000 < 100) ? 200.0f : 0.0f;
         
         pazerville.update();
         pazerville.draw();
@@ -267,6 +264,10 @@ void example_dynamic_growth() {
     
     pazerville.setDamping(0.92f);
     
+    // Only the new node and its neighbourhood are simulated after each
+    // addition; the settled part of the graph sleeps
+    pazerville.setActiveSet(true);
+    
     // Start with single node
     pazerville.addNode(PAZERVILLE_WIDTH/2, PAZERVILLE_HEIGHT/2, 1.0f, COLOR_RED, 4);
     
@@ -305,26 +306,32 @@ void example_dynamic_growth() {
 // ============================================================================
 
 void switchTopology(PazervilleDisplay *pazerville, int index) {
-    // Clear by recreating (not implemented in current version)
-    // In a real implementation, you'd have a reset function
+    // Layouts are baked offline by tools/bake_layout.cpp. Each switch morphs
+    // the live graph towards the new one over 90 steps, so only the nodes
+    // and springs that differ move
+    const PazervilleLayout *layout = nullptr;
     
     switch (index) {
         case 0:
-            PazervilleExamples::createStarNetwork(pazerville, 5);
+            layout = &pazerville_layout_star_5;
             break;
         case 1:
-            PazervilleExamples::createRingNetwork(pazerville, 6);
+            layout = &pazerville_layout_ring_6;
             break;
         case 2:
-            PazervilleExamples::createChainNetwork(pazerville, 5);
+            layout = &pazerville_layout_chain_5;
             break;
         case 3:
-            PazervilleExamples::createGridNetwork(pazerville, 2, 2);
+            layout = &pazerville_layout_grid_2x2;
             break;
         case 4:
-            PazervilleExamples::createBinaryTreeNetwork(pazerville);
+            layout = &pazerville_layout_tree;
             break;
     }
+    
+    if (layout) {
+        pazerville->morphTo(*layout, 90);
+    }
 }
 
 void handleControlCommand(PazervilleDisplay *pazerville, char cmd) {
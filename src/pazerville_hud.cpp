@@ -0,0 +1,155 @@
+#include "../include/pazerville_hud.h"
+
+// Scratch size for formatted numbers: room for any int32_t pair plus a
+// short suffix, so formatting never truncates; setText() cuts to the field
+#define PAZERVILLE_HUD_FORMAT_CHARS 40
+
+// Constructor
+PazervilleHUD::PazervilleHUD(ILI9341Display *tft_display) {
+    display = tft_display;
+    field_count = 0;
+    bg = COLOR_BLACK;
+    top = 0;
+    bottom = 0;
+    needs_clear = true;
+}
+
+// Add a labelled field
+int PazervilleHUD::addField(const char *label, uint16_t x, uint16_t y, uint16_t color) {
+    if (field_count >= PAZERVILLE_HUD_MAX_FIELDS) {
+        return -1;
+    }
+    
+    PazervilleHUDField &f = fields[field_count];
+    f.label = label;
+    f.x = x;
+    f.y = y;
+    f.color = color;
+    f.text[0] = 0;
+    memset(f.shown, ' ', PAZERVILLE_HUD_FIELD_CHARS);
+    f.shown[PAZERVILLE_HUD_FIELD_CHARS] = 0;
+    f.label_drawn = false;
+    
+    uint16_t end = y + display->getTextHeight();
+    if (field_count == 0 || y < top) {
+        top = y;
+    }
+    if (end > bottom) {
+        bottom = end;
+    }
+    needs_clear = true;
+    
+    return field_count++;
+}
+
+// Remove every field
+void PazervilleHUD::clearFields() {
+    field_count = 0;
+    top = 0;
+    bottom = 0;
+}
+
+// Set a field's text, truncated to PAZERVILLE_HUD_FIELD_CHARS
+void PazervilleHUD::setText(int idx, const char *text) {
+    if (idx < 0 || idx >= field_count) return;
+    
+    snprintf(fields[idx].text, sizeof(fields[idx].text), "%.*s", PAZERVILLE_HUD_FIELD_CHARS, text);
+}
+
+// Set a field to an integer
+void PazervilleHUD::setInt(int idx, int32_t value, const char *suffix) {
+    char buf[PAZERVILLE_HUD_FORMAT_CHARS];
+    snprintf(buf, sizeof(buf), "%ld%s", (long)value, suffix);
+    setText(idx, buf);
+}
+
+// Set a field to a fixed-point number; integer formatting only, so it
+// works without printf float support
+void PazervilleHUD::setFixed(int idx, float value, uint8_t decimals, const char *suffix) {
+    if (decimals > PAZERVILLE_HUD_MAX_DECIMALS) decimals = PAZERVILLE_HUD_MAX_DECIMALS;
+    
+    int32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    
+    bool negative = value < 0.0f;
+    int32_t scaled = (int32_t)((negative ? -value : value) * scale + 0.5f);
+    
+    char buf[PAZERVILLE_HUD_FORMAT_CHARS];
+    if (decimals == 0) {
+        snprintf(buf, sizeof(buf), "%s%ld%s", negative ? "-" : "", (long)scaled, suffix);
+    } else {
+        snprintf(buf, sizeof(buf), "%s%ld.%0*ld%s", negative ? "-" : "",
+                 (long)(scaled / scale), (int)decimals, (long)(scaled % scale), suffix);
+    }
+    setText(idx, buf);
+}
+
+// Clear the band and redraw every label and value on the next render()
+void PazervilleHUD::invalidate() {
+    needs_clear = true;
+}
+
+// Draw what changed since the last render(). Each run of differing
+// characters is drawn as one string; a shorter value blanks only the cells
+// it no longer covers.
+void PazervilleHUD::render() {
+    if (!display) return;
+    
+    uint16_t advance = display->getFont()->advance;
+    char run[PAZERVILLE_HUD_FIELD_CHARS + 1];
+    
+    if (needs_clear) {
+        needs_clear = false;
+        if (bottom > top) {
+            display->fillRect(0, top, display->getWidth(), bottom - top, bg);
+        }
+        for (int i = 0; i < field_count; i++) {
+            fields[i].label_drawn = false;
+            memset(fields[i].shown, ' ', PAZERVILLE_HUD_FIELD_CHARS);
+        }
+    }
+    
+    for (int i = 0; i < field_count; i++) {
+        PazervilleHUDField &f = fields[i];
+        uint16_t value_x = f.x;
+        
+        if (f.label) {
+            if (!f.label_drawn) {
+                display->drawString(f.x, f.y, f.label, f.color, bg);
+            }
+            value_x += display->getTextWidth(f.label);
+        }
+        
+        // One pass past the end flushes the last run
+        bool ended = false;
+        int run_start = -1;
+        int run_len = 0;
+        for (int c = 0; c <= PAZERVILLE_HUD_FIELD_CHARS; c++) {
+            bool differs = false;
+            char want = ' ';
+            if (c < PAZERVILLE_HUD_FIELD_CHARS) {
+                if (!ended && f.text[c]) {
+                    want = f.text[c];
+                } else {
+                    ended = true;
+                }
+                differs = f.shown[c] != want;
+            }
+            
+            if (differs) {
+                if (run_start < 0) run_start = c;
+                run[run_len++] = want;
+                f.shown[c] = want;
+            } else if (run_start >= 0) {
+                run[run_len] = 0;
+                display->drawString(value_x + run_start * advance, f.y, run, f.color, bg);
+                run_start = -1;
+                run_len = 0;
+            }
+        }
+        
+        f.label_drawn = true;
+    }
+}
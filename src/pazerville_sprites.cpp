@@ -0,0 +1,134 @@
+#include "../include/pazerville_sprites.h"
+
+// Constructor
+PazervilleSpriteCache::PazervilleSpriteCache() {
+    clock = 0;
+    hits = 0;
+    misses = 0;
+    clear();
+}
+
+// Drop every cached image
+void PazervilleSpriteCache::clear() {
+    for (int i = 0; i < PAZERVILLE_SPRITE_SLOTS; i++) {
+        slots[i].valid = false;
+        slots[i].last_used = 0;
+    }
+}
+
+// Look up a node image, rendering it into the LRU slot on a miss
+const ILI9341Sprite* PazervilleSpriteCache::get(uint8_t radius, uint16_t color, PazervilleNodeStyle style) {
+    if (radius > PAZERVILLE_SPRITE_MAX_RADIUS) {
+        return nullptr;
+    }
+    
+    clock++;
+    int victim = 0;
+    for (int i = 0; i < PAZERVILLE_SPRITE_SLOTS; i++) {
+        PazervilleSpriteSlot &slot = slots[i];
+        if (slot.valid && slot.radius == radius && slot.color == color && slot.style == style) {
+            slot.last_used = clock;
+            hits++;
+            return &slot.sprite;
+        }
+        
+        // Invalid slots have a zero stamp, so they are taken first
+        if (slots[i].last_used < slots[victim].last_used) {
+            victim = i;
+        }
+    }
+    
+    PazervilleSpriteSlot &slot = slots[victim];
+    slot.radius = radius;
+    slot.color = color;
+    slot.style = style;
+    slot.valid = true;
+    slot.last_used = clock;
+    render(slot);
+    misses++;
+    return &slot.sprite;
+}
+
+// Rasterize a node image and its coverage mask
+void PazervilleSpriteCache::render(PazervilleSpriteSlot &slot) {
+    int r = slot.radius;
+    int size = 2 * r + 1;
+    
+    slot.sprite.width = size;
+    slot.sprite.height = size;
+    slot.sprite.pixels = slot.pixels;
+    slot.sprite.mask = slot.mask;
+    
+    for (int i = 0; i < size * size; i++) {
+        slot.pixels[i] = slot.color;
+        slot.mask[i] = 0;
+    }
+    
+    switch (slot.style) {
+        case PAZERVILLE_NODE_CLASSIC: {
+            // Same pixels as drawCircle() plus the fillRect() centre
+            int x = 0;
+            int y = r;
+            int dp = 1 - r;
+            while (x <= y) {
+                slot.mask[(r + y) * size + r + x] = 255;
+                slot.mask[(r + y) * size + r - x] = 255;
+                slot.mask[(r - y) * size + r + x] = 255;
+                slot.mask[(r - y) * size + r - x] = 255;
+                slot.mask[(r + x) * size + r + y] = 255;
+                slot.mask[(r + x) * size + r - y] = 255;
+                slot.mask[(r - x) * size + r + y] = 255;
+                slot.mask[(r - x) * size + r - y] = 255;
+                if (dp < 0) {
+                    dp = dp + 2 * x + 3;
+                } else {
+                    dp = dp + 2 * (x - y) + 5;
+                    y--;
+                }
+                x++;
+            }
+            for (int py = r - r / 2; py < r - r / 2 + r; py++) {
+                for (int px = r - r / 2; px < r - r / 2 + r; px++) {
+                    slot.mask[py * size + px] = 255;
+                }
+            }
+            break;
+        }
+        case PAZERVILLE_NODE_DISC:
+        case PAZERVILLE_NODE_OUTLINED: {
+            // r * r + r rounds the edge the way a midpoint circle does
+            int outer = r * r + r;
+            int inner = (r - 1) * (r - 1) + (r - 1);
+            for (int py = 0; py < size; py++) {
+                for (int px = 0; px < size; px++) {
+                    int d = (px - r) * (px - r) + (py - r) * (py - r);
+                    if (d > outer) continue;
+                    
+                    slot.mask[py * size + px] = 255;
+                    if (slot.style == PAZERVILLE_NODE_OUTLINED && d > inner) {
+                        slot.pixels[py * size + px] = COLOR_WHITE;
+                    }
+                }
+            }
+            break;
+        }
+        case PAZERVILLE_NODE_DISC_AA: {
+            // 4x4 samples per pixel against a radius of r + 0.5
+            float limit = (r + 0.5f) * (r + 0.5f);
+            for (int py = 0; py < size; py++) {
+                for (int px = 0; px < size; px++) {
+                    int covered = 0;
+                    for (int sy = 0; sy < 4; sy++) {
+                        float dy = py - r + (sy - 1.5f) * 0.25f;
+                        for (int sx = 0; sx < 4; sx++) {
+                            float dx = px - r + (sx - 1.5f) * 0.25f;
+                            if (dx * dx + dy * dy <= limit) covered++;
+                        }
+                    }
+                    slot.mask[py * size + px] = (covered == 16) ? 255 : covered * 16;
+                }
+            }
+            break;
+        }
+    }
+}
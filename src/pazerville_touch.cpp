@@ -0,0 +1,199 @@
+#include "../include/pazerville_touch.h"
+#include "../include/ili9341_transport.h"
+
+#ifdef TEENSYDUINO
+static IntervalTimer touch_timer;
+static PazervilleTouch *touch_instance = nullptr;
+
+// Sampling interrupt
+static void touchSampleISR() {
+    touch_instance->sampleTick();
+}
+#endif
+
+// Constructor
+PazervilleTouch::PazervilleTouch() {
+    cs_pin = PAZERVILLE_TOUCH_CS;
+    source = nullptr;
+    sample_rate = PAZERVILLE_TOUCH_SAMPLE_RATE;
+    setCalibration(PAZERVILLE_TOUCH_RAW_X_MIN, PAZERVILLE_TOUCH_RAW_X_MAX,
+                   PAZERVILLE_TOUCH_RAW_Y_MIN, PAZERVILLE_TOUCH_RAW_Y_MAX);
+    smoothing = PAZERVILLE_TOUCH_SMOOTHING;
+    pressure_threshold = PAZERVILLE_TOUCH_PRESSURE;
+    filtered_x = filtered_y = 0.0f;
+    down = false;
+    disagree = 0;
+    sample_count = 0;
+    deferred_ticks = 0;
+    sampling = false;
+}
+
+// Configure the chip select and start sampling in the background if a
+// controller answers
+bool PazervilleTouch::begin(uint8_t cs, uint32_t rate) {
+    cs_pin = cs;
+    sample_rate = rate;
+    pinMode(cs_pin, OUTPUT);
+    digitalWrite(cs_pin, HIGH);
+    SPI.begin();
+    
+    if (!probe()) {
+        return false;
+    }
+    
+#ifdef TEENSYDUINO
+    touch_instance = this;
+    return touch_timer.begin(touchSampleISR, 1000000.0f / rate);
+#else
+    return false;
+#endif
+}
+
+// Stop background sampling
+void PazervilleTouch::end() {
+#ifdef TEENSYDUINO
+    touch_timer.end();
+    touch_instance = nullptr;
+#endif
+}
+
+// Set the raw readings that map to the screen edges
+void PazervilleTouch::setCalibration(uint16_t x_min, uint16_t x_max, uint16_t y_min, uint16_t y_max,
+                                     uint16_t w, uint16_t h) {
+    raw_x_min = x_min;
+    raw_x_max = (x_max != x_min) ? x_max : x_min + 1;
+    raw_y_min = y_min;
+    raw_y_max = (y_max != y_min) ? y_max : y_min + 1;
+    width = w;
+    height = h;
+}
+
+// One 12-bit conversion. The result follows the command byte after a
+// busy clock, left-aligned in the next 16 clocks.
+uint16_t PazervilleTouch::convert(uint8_t command, uint32_t now) {
+    if (source) {
+        return source(command, now);
+    }
+    
+    SPI.transfer(command);
+    return (SPI.transfer16(0) >> 3) & PAZERVILLE_TOUCH_FULL_SCALE;
+}
+
+// Median of three conversions, to reject the spikes a resistive panel
+// gives while the pen is landing or lifting
+uint16_t PazervilleTouch::convertMedian(uint8_t command, uint32_t now) {
+    uint16_t a = convert(command, now);
+    uint16_t b = convert(command, now);
+    uint16_t c = convert(command, now);
+    
+    if (a > b) { uint16_t t = a; a = b; b = t; }
+    if (b > c) { b = c; }
+    return (a > b) ? a : b;
+}
+
+// Select the controller for a burst of conversions
+void PazervilleTouch::select() {
+    if (!source) {
+        SPI.beginTransaction(SPISettings(PAZERVILLE_TOUCH_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+        digitalWrite(cs_pin, LOW);
+    }
+}
+
+// Release the controller and the bus
+void PazervilleTouch::deselect() {
+    if (!source) {
+        digitalWrite(cs_pin, HIGH);
+        SPI.endTransaction();
+    }
+}
+
+// Pressure of the pen, 0 when released
+int32_t PazervilleTouch::readPressure(uint32_t now) {
+    return convert(XPT2046_CMD_Z1, now) + PAZERVILLE_TOUCH_FULL_SCALE - convert(XPT2046_CMD_Z2, now);
+}
+
+// A released XPT2046 reads Z1 near 0 and Z2 near full scale. Without one,
+// T_DO is not driven and both read the same level, which would look like a
+// press that never ends, so begin() refuses to sample.
+bool PazervilleTouch::probe() {
+    uint32_t now = micros();
+    select();
+    int32_t z = readPressure(now);
+    deselect();
+    return z < pressure_threshold;
+}
+
+// Bus handed over by a flush that a tick found in progress
+static void touchBusGranted(void *context) {
+    ((PazervilleTouch *)context)->sampleTick();
+}
+
+// Take one sample, unless the panel holds the bus: then ask the flush to
+// hand it over at its next row boundary, where this runs again from the
+// frame loop. A tick that interrupts such a handed-over sample is dropped.
+void PazervilleTouch::sampleTick() {
+    if (ili9341_bus_busy) {
+        deferred_ticks = deferred_ticks + 1;
+        ili9341_requestBus(touchBusGranted, this);
+        return;
+    }
+    if (__atomic_exchange_n(&sampling, true, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    
+    sample();
+    __atomic_store_n(&sampling, false, __ATOMIC_RELEASE);
+}
+
+// Read the controller, debounce and filter, and publish the result
+void PazervilleTouch::sample() {
+    uint32_t now = micros();
+    select();
+    
+    int32_t z = readPressure(now);
+    bool pressed = z >= pressure_threshold;
+    uint16_t raw_x = 0, raw_y = 0;
+    if (pressed) {
+        raw_x = convertMedian(XPT2046_CMD_X, now);
+        raw_y = convertMedian(XPT2046_CMD_Y, now);
+    }
+    
+    deselect();
+    
+    // Debounce: the state flips only after enough samples disagree with it
+    bool was_down = down;
+    if (pressed != down) {
+        if (++disagree >= PAZERVILLE_TOUCH_DEBOUNCE) {
+            down = pressed;
+            disagree = 0;
+        }
+    } else {
+        disagree = 0;
+    }
+    
+    // Position only moves on samples taken with the pen down
+    if (down && pressed) {
+        float x = (float)((int32_t)raw_x - raw_x_min) * width / ((int32_t)raw_x_max - raw_x_min);
+        float y = (float)((int32_t)raw_y - raw_y_min) * height / ((int32_t)raw_y_max - raw_y_min);
+        if (!was_down) {
+            filtered_x = x;
+            filtered_y = y;
+        } else {
+            filtered_x += (x - filtered_x) * smoothing;
+            filtered_y += (y - filtered_y) * smoothing;
+        }
+    } else if (down == was_down && !down) {
+        return;  // still released, nothing to report
+    }
+    
+    PazervilleTouchPoint &point = points.slot();
+    int32_t px = (int32_t)(filtered_x + 0.5f);
+    int32_t py = (int32_t)(filtered_y + 0.5f);
+    point.x = (px < 0) ? 0 : (px >= width) ? width - 1 : px;
+    point.y = (py < 0) ? 0 : (py >= height) ? height - 1 : py;
+    point.pressure = down ? (uint16_t)(z > 0 ? z : 0) : 0;
+    point.down = down;
+    point.time_us = now;
+    point.sample_index = ++sample_count;
+    points.publish();
+}
@@ -0,0 +1,112 @@
+/*
+ * Audio Analysis Replay
+ *
+ * Feeds a 16-bit PCM WAV file through PazervilleAudio one sample at a time,
+ * exactly as the sampling interrupt does on the Teensy, and prints the
+ * published band values for every block.
+ *
+ * Build (from the repository root):
+ *   g++ -std=gnu++14 -O2 -Itools/host -Iinclude -I. \
+ *       tools/audio_replay.cpp tools/host/host_core.cpp \
+ *       src/pazerville_audio.cpp src/pazerville_math.cpp -o audio_replay
+ *
+ * Usage:
+ *   ./audio_replay file.wav
+ */
+
+#include "pazerville_audio.h"
+
+// Read a little-endian integer of 'bytes' bytes
+static uint32_t readLE(FILE *f, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        int c = fgetc(f);
+        if (c == EOF) return 0;
+        value |= (uint32_t)c << (8 * i);
+    }
+    return value;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s file.wav\n", argv[0]);
+        return 1;
+    }
+    
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    
+    char tag[4];
+    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "RIFF", 4) != 0) {
+        fprintf(stderr, "not a RIFF file\n");
+        return 1;
+    }
+    readLE(f, 4);
+    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "WAVE", 4) != 0) {
+        fprintf(stderr, "not a WAVE file\n");
+        return 1;
+    }
+    
+    // Walk the chunks until the sample data
+    uint16_t channels = 0, bits = 0;
+    uint32_t rate = 0, data_size = 0;
+    while (fread(tag, 1, 4, f) == 4) {
+        uint32_t size = readLE(f, 4);
+        if (memcmp(tag, "fmt ", 4) == 0) {
+            uint16_t format = readLE(f, 2);
+            channels = readLE(f, 2);
+            rate = readLE(f, 4);
+            fseek(f, 6, SEEK_CUR);  // byte rate, block align
+            bits = readLE(f, 2);
+            fseek(f, size - 16, SEEK_CUR);
+            if (format != 1 || bits != 16) {
+                fprintf(stderr, "only 16-bit PCM is supported\n");
+                return 1;
+            }
+        } else if (memcmp(tag, "data", 4) == 0) {
+            data_size = size;
+            break;
+        } else {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+    if (!channels || !data_size) {
+        fprintf(stderr, "missing fmt or data chunk\n");
+        return 1;
+    }
+    
+    PazervilleAudio audio;
+    audio.setSampleRate(rate);
+    
+    printf("# %u Hz, %u channel(s), band start bins:", rate, channels);
+    for (int b = 0; b <= PAZERVILLE_AUDIO_BANDS; b++) {
+        printf(" %u", audio.getBandStartBin(b));
+    }
+    printf("\n# block  rms    bands...\n");
+    
+    // Downmix to mono and push; every completed block is read back at
+    // once, so results are never more than one block behind the input
+    uint32_t frames_total = data_size / (2 * channels);
+    PazervilleAudioFrame frame;
+    for (uint32_t i = 0; i < frames_total; i++) {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++) {
+            sum += (int16_t)readLE(f, 2);
+        }
+        audio.pushSample((int16_t)(sum / channels));
+        
+        if (audio.read(&frame)) {
+            printf("%6u  %.3f ", frame.block_index, frame.rms);
+            for (int b = 0; b < PAZERVILLE_AUDIO_BANDS; b++) {
+                printf(" %.3f", frame.band[b]);
+            }
+            printf("\n");
+        }
+    }
+    
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Offline Layout Baker
+ *
+ * Runs the Pazerville physics on the host until a topology settles and
+ * writes the resulting node positions and edges as constexpr tables that
+ * PazervilleDisplay::loadLayout() copies straight from flash at boot.
+ *
+ * Build (from the repository root):
+ *   g++ -std=gnu++14 -O2 -Itools/host -Iinclude -I. \
+ *       tools/bake_layout.cpp tools/host/host_core.cpp \
+ *       src/pazerville_display.cpp src/pazerville_hud.cpp src/pazerville_sprites.cpp \
+ *       src/pazerville_math.cpp src/pazerville_commands.cpp src/ili9341_display.cpp \
+ *       src/ili9341_transport.cpp src/ili9341_font.cpp -o bake_layout
+ *
+ * Usage:
+ *   ./bake_layout [--damping D] [--gravity G] [--time-step T] [-o file.h] topology...
+ *
+ * Topologies:
+ *   star:N  ring:N  chain:N  complete:N  grid:CxR  tree  random:N:E[:seed]
+ */
+
+#include "ili9341_display.h"
+#include "pazerville_display.h"
+#include "pazerville_examples.h"
+
+#include <string>
+#include <vector>
+
+// Settling criteria
+#define BAKE_MAX_STEPS          200000
+#define BAKE_REST_MOTION        0.0001f  // pixels per step
+#define BAKE_REST_STEPS         500
+
+static float bake_damping = 0.95f;
+static float bake_gravity = 0.0f;
+static float bake_time_step = 0.01f;
+
+// Build the named topology into a fresh simulation
+static bool buildTopology(PazervilleDisplay *pazerville, const std::string &spec) {
+    int a = 0, b = 0, seed = 1;
+
+    if (sscanf(spec.c_str(), "star:%d", &a) == 1) {
+        PazervilleExamples::createStarNetwork(pazerville, a);
+    } else if (sscanf(spec.c_str(), "ring:%d", &a) == 1) {
+        PazervilleExamples::createRingNetwork(pazerville, a);
+    } else if (sscanf(spec.c_str(), "chain:%d", &a) == 1) {
+        PazervilleExamples::createChainNetwork(pazerville, a);
+    } else if (sscanf(spec.c_str(), "complete:%d", &a) == 1) {
+        PazervilleExamples::createCompleteNetwork(pazerville, a);
+    } else if (sscanf(spec.c_str(), "grid:%dx%d", &a, &b) == 2) {
+        PazervilleExamples::createGridNetwork(pazerville, a, b);
+    } else if (spec == "tree") {
+        PazervilleExamples::createBinaryTreeNetwork(pazerville);
+    } else if (sscanf(spec.c_str(), "random:%d:%d:%d", &a, &b, &seed) >= 2) {
+        srand(seed);
+        PazervilleExamples::createRandomNetwork(pazerville, a, b);
+    } else {
+        return false;
+    }
+    return pazerville->getNodeCount() > 0;
+}
+
+// Step until no node has moved more than BAKE_REST_MOTION for
+// BAKE_REST_STEPS steps. Motion is used rather than velocity because
+// float positions stop changing before residual velocities reach zero.
+static int settle(PazervilleDisplay *pazerville) {
+    std::vector<float> last_x(pazerville->getNodeCount());
+    std::vector<float> last_y(pazerville->getNodeCount());
+    int rest_steps = 0;
+
+    for (int step = 0; step < BAKE_MAX_STEPS; step++) {
+        for (int i = 0; i < pazerville->getNodeCount(); i++) {
+            last_x[i] = pazerville->getNode(i)->x;
+            last_y[i] = pazerville->getNode(i)->y;
+        }
+
+        pazerville->update();
+
+        float max_motion = 0.0f;
+        for (int i = 0; i < pazerville->getNodeCount(); i++) {
+            PazervilleNode *node = pazerville->getNode(i);
+            if (!node->active) continue;
+            max_motion = fmaxf(max_motion, fabsf(node->x - last_x[i]));
+            max_motion = fmaxf(max_motion, fabsf(node->y - last_y[i]));
+        }
+
+        if (max_motion < BAKE_REST_MOTION) {
+            if (++rest_steps >= BAKE_REST_STEPS) {
+                return step + 1;
+            }
+        } else {
+            rest_steps = 0;
+        }
+    }
+    return -1;
+}
+
+// Turn a topology spec into a C identifier ("grid:3x3" -> "grid_3x3")
+static std::string identifierFor(const std::string &spec) {
+    std::string id = "pazerville_layout_";
+    for (char c : spec) {
+        id += (isalnum((unsigned char)c) ? c : '_');
+    }
+    return id;
+}
+
+static void emitLayout(FILE *out, PazervilleDisplay *pazerville, const std::string &spec, int steps) {
+    std::string id = identifierFor(spec);
+
+    fprintf(out, "// %s: settled after %d steps\n", spec.c_str(), steps);
+    fprintf(out, "constexpr PazervilleLayoutNode %s_nodes[] PROGMEM = {\n", id.c_str());
+    for (int i = 0; i < pazerville->getNodeCount(); i++) {
+        PazervilleNode *n = pazerville->getNode(i);
+        fprintf(out, "    { %.3ff, %.3ff, %.3ff, 0x%04X, %u },\n",
+                n->x, n->y, n->mass, n->color, n->radius);
+    }
+    fprintf(out, "};\n");
+
+    fprintf(out, "constexpr PazervilleLayoutEdge %s_edges[] PROGMEM = {\n", id.c_str());
+    for (int i = 0; i < pazerville->getEdgeCount(); i++) {
+        PazervilleEdge *e = pazerville->getEdge(i);
+        fprintf(out, "    { %d, %d, %.3ff, %.3ff, 0x%04X },\n",
+                e->node1, e->node2, e->spring_constant, e->rest_length, e->color);
+    }
+    fprintf(out, "};\n");
+
+    fprintf(out, "constexpr PazervilleLayout %s = {\n", id.c_str());
+    fprintf(out, "    %s_nodes, %d,\n", id.c_str(), pazerville->getNodeCount());
+    fprintf(out, "    %s_edges, %d\n", id.c_str(), pazerville->getEdgeCount());
+    fprintf(out, "};\n\n");
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = nullptr;
+    std::vector<std::string> specs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--damping" && i + 1 < argc) {
+            bake_damping = atof(argv[++i]);
+        } else if (arg == "--gravity" && i + 1 < argc) {
+            bake_gravity = atof(argv[++i]);
+        } else if (arg == "--time-step" && i + 1 < argc) {
+            bake_time_step = atof(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            specs.push_back(arg);
+        }
+    }
+
+    if (specs.empty()) {
+        fprintf(stderr, "usage: %s [--damping D] [--gravity G] [--time-step T] [-o file.h] topology...\n", argv[0]);
+        return 1;
+    }
+
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot open %s\n", out_path);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by tools/bake_layout.cpp - do not edit\n");
+    fprintf(out, "// damping=%.3f gravity=%.3f time_step=%.4f\n\n", bake_damping, bake_gravity, bake_time_step);
+    fprintf(out, "#ifndef PAZERVILLE_BAKED_LAYOUTS_H\n#define PAZERVILLE_BAKED_LAYOUTS_H\n\n");
+    fprintf(out, "#include \"pazerville_display.h\"\n\n");
+
+    ILI9341Display tft;
+    tft.initialize();
+
+    for (const std::string &spec : specs) {
+        PazervilleDisplay pazerville(&tft);
+        pazerville.initialize();
+        pazerville.setDamping(bake_damping);
+        pazerville.setGravity(bake_gravity);
+        pazerville.setTimeStep(bake_time_step);
+
+        if (!buildTopology(&pazerville, spec)) {
+            fprintf(stderr, "unknown or empty topology: %s\n", spec.c_str());
+            return 1;
+        }
+
+        int steps = settle(&pazerville);
+        if (steps < 0) {
+            fprintf(stderr, "warning: %s did not settle in %d steps\n", spec.c_str(), BAKE_MAX_STEPS);
+            steps = BAKE_MAX_STEPS;
+        }
+        emitLayout(out, &pazerville, spec, steps);
+    }
+
+    fprintf(out, "#endif // PAZERVILLE_BAKED_LAYOUTS_H\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * Framebuffer Flush Test
+ *
+ * Draws into the driver's framebuffer and flushes it into ILI9341HostSink,
+ * then checks that the panel image matches what was drawn and that
+ * updateDisplay() sent only the dirty spans, in each colour mode and at
+ * half resolution.
+ *
+ * Build (from the repository root):
+ *   g++ -std=gnu++14 -O2 -Itools/host -Iinclude -I. \
+ *       tools/flush_test.cpp tools/host/host_core.cpp \
+ *       src/ili9341_display.cpp src/ili9341_transport.cpp src/ili9341_font.cpp -o flush_test
+ *
+ * Usage:
+ *   ./flush_test         exits non-zero if any check fails
+ */
+
+#include "ili9341_display.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+// Count panel pixels in a rectangle that differ from 'color'
+static uint32_t mismatches(ILI9341HostSink &sink, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    uint32_t bad = 0;
+    for (uint16_t py = y; py < y + h; py++) {
+        for (uint16_t px = x; px < x + w; px++) {
+            if (sink.pixelAt(px, py) != color) bad++;
+        }
+    }
+    return bad;
+}
+
+// Only the dirty spans go out, coalesced, and a clean frame sends nothing
+static void testDirtySpans() {
+    ILI9341Display tft;
+    tft.initialize();
+    ILI9341HostSink &sink = tft.getTransport();
+    
+    tft.fillRect(10, 20, 30, 5, COLOR_RED);
+    sink.resetCounters();
+    tft.updateDisplay();
+    CHECK(sink.pixels == 30 * 5, "rectangle sent %u pixels", sink.pixels);
+    CHECK(sink.transactions == 1, "equal spans took %u windows", sink.transactions);
+    CHECK(mismatches(sink, 10, 20, 30, 5, COLOR_RED) == 0, "rectangle not on the panel");
+    CHECK(sink.pixelAt(9, 20) == COLOR_BLACK && sink.pixelAt(40, 24) == COLOR_BLACK, "pixels outside the rectangle changed");
+    
+    sink.resetCounters();
+    tft.updateDisplay();
+    CHECK(sink.pixels == 0 && sink.transactions == 0, "clean frame sent %u pixels", sink.pixels);
+    
+    // Spans differ per row, so the window changes with them
+    tft.drawLine(100, 100, 100, 109, COLOR_GREEN);
+    tft.drawLine(200, 105, 219, 105, COLOR_BLUE);
+    sink.resetCounters();
+    tft.updateDisplay();
+    CHECK(sink.pixels == 9 + 120, "lines sent %u pixels", sink.pixels);
+    CHECK(mismatches(sink, 100, 100, 1, 10, COLOR_GREEN) == 0, "vertical line not on the panel");
+    CHECK(mismatches(sink, 200, 105, 20, 1, COLOR_BLUE) == 0, "horizontal line not on the panel");
+    
+    // The panel now holds exactly the framebuffer
+    const uint16_t *fb = tft.getFramebuffer();
+    uint32_t bad = 0;
+    for (uint16_t y = 0; y < ILI9341_HEIGHT; y++) {
+        for (uint16_t x = 0; x < ILI9341_WIDTH; x++) {
+            if (sink.pixelAt(x, y) != fb[y * ILI9341_WIDTH + x]) bad++;
+        }
+    }
+    CHECK(bad == 0, "%u panel pixels differ from the framebuffer", bad);
+}
+
+// Indexed pixels are expanded through the palette on the way out
+static void testIndexed(ILI9341ColorMode mode, const char *name) {
+    ILI9341Display tft;
+    tft.initialize(mode);
+    ILI9341HostSink &sink = tft.getTransport();
+    
+    tft.fillRect(50, 60, 8, 8, COLOR_YELLOW);
+    tft.fillRect(58, 60, 8, 8, COLOR_CYAN);
+    tft.updateDisplay();
+    CHECK(mismatches(sink, 50, 60, 8, 8, COLOR_YELLOW) == 0, "%s: first colour not expanded", name);
+    CHECK(mismatches(sink, 58, 60, 8, 8, COLOR_CYAN) == 0, "%s: second colour not expanded", name);
+    
+    // A palette effect needs no redraw, only a flush
+    tft.fadePalette(0);
+    tft.updateDisplay();
+    CHECK(mismatches(sink, 50, 60, 16, 8, COLOR_BLACK) == 0, "%s: faded palette not flushed", name);
+}
+
+// Half resolution doubles every pixel and line on the way out
+static void testHalfResolution() {
+    ILI9341Display tft;
+    tft.initialize(ILI9341_COLOR_RGB565, ILI9341_RES_HALF);
+    ILI9341HostSink &sink = tft.getTransport();
+    
+    tft.fillRect(20, 30, 10, 6, COLOR_MAGENTA);
+    sink.resetCounters();
+    tft.updateDisplay();
+    CHECK(sink.pixels == 10 * 6, "half-resolution rectangle sent %u pixels", sink.pixels);
+    CHECK(mismatches(sink, 20, 30, 10, 6, COLOR_MAGENTA) == 0, "half-resolution rectangle not on the panel");
+    CHECK(sink.pixelAt(19, 30) == COLOR_BLACK && sink.pixelAt(20, 36) == COLOR_BLACK, "half-resolution rectangle overran");
+}
+
+int main() {
+    testDirtySpans();
+    testIndexed(ILI9341_COLOR_INDEXED8, "indexed8");
+    testIndexed(ILI9341_COLOR_INDEXED4, "indexed4");
+    testHalfResolution();
+    
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("flush_test: ok\n");
+    return 0;
+}
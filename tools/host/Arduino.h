@@ -0,0 +1,69 @@
+/*
+ * Minimal Arduino core stand-in for host-side tools
+ *
+ * Only the calls used by the driver and physics sources are provided.
+ * Time is virtual: delay() advances the clock instead of sleeping so that
+ * tools can run the simulation far faster than real time.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+#define PROGMEM
+
+// Virtual clock in microseconds
+extern uint64_t host_clock_us;
+
+inline void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+inline void digitalWriteFast(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+inline int digitalRead(uint8_t pin) { (void)pin; return LOW; }
+inline int analogRead(uint8_t pin) { (void)pin; return 0; }
+
+inline void delay(uint32_t ms) { host_clock_us += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(uint32_t us) { host_clock_us += us; }
+inline uint32_t millis() { return (uint32_t)(host_clock_us / 1000); }
+inline uint32_t micros() { return (uint32_t)host_clock_us; }
+
+// Serial port mapped onto stderr so tool output on stdout stays clean
+class HostSerial {
+public:
+    void begin(uint32_t baud) { (void)baud; }
+    int available() { return 0; }
+    int read() { return -1; }
+    void print(const char *s) { fputs(s, stderr); }
+    void print(int v) { fprintf(stderr, "%d", v); }
+    void print(unsigned int v) { fprintf(stderr, "%u", v); }
+    void print(long v) { fprintf(stderr, "%ld", v); }
+    void print(unsigned long v) { fprintf(stderr, "%lu", v); }
+    void print(double v) { fprintf(stderr, "%.2f", v); }
+    void println() { fputc('\n', stderr); }
+    template <typename T> void println(T v) { print(v); println(); }
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,41 @@
+/*
+ * Minimal SPI library stand-in for host-side tools
+ *
+ * Transfers are discarded; reads return zero.
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+#define SPI_CLOCK_DIV2 0x04
+
+class SPISettings {
+public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bit_order, uint8_t data_mode) {
+        (void)clock; (void)bit_order; (void)data_mode;
+    }
+};
+
+class SPIClass {
+public:
+    void begin() {}
+    void setClockDivider(uint8_t div) { (void)div; }
+    void setBitOrder(uint8_t order) { (void)order; }
+    void setDataMode(uint8_t mode) { (void)mode; }
+    void beginTransaction(SPISettings settings) { (void)settings; }
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data) { (void)data; return 0; }
+    uint16_t transfer16(uint16_t data) { (void)data; return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
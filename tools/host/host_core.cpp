@@ -0,0 +1,10 @@
+/*
+ * Storage for the host-side Arduino stand-ins
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+
+uint64_t host_clock_us = 0;
+HostSerial Serial;
+SPIClass SPI;
@@ -0,0 +1,101 @@
+/*
+ * Math Precision Check
+ *
+ * Sweeps pzInvSqrt, pzSqrt, pzSin and pzCos against double-precision libm
+ * for the tier the tool was built with, and fails if any error exceeds the
+ * bound documented for that tier. Square roots are checked by relative
+ * error, sine and cosine by absolute error.
+ *
+ * Build (from the repository root), once per tier 0, 1 and 2:
+ *   g++ -std=gnu++14 -O2 -Iinclude -DPAZERVILLE_MATH_PRECISION=1 \
+ *       tools/math_accuracy.cpp src/pazerville_math.cpp -o math_accuracy
+ *
+ * Usage:
+ *   ./math_accuracy      prints the worst errors, exits non-zero on a miss
+ */
+
+#include "pazerville_math.h"
+
+#include <stdio.h>
+
+// Documented maximum errors (DOCUMENTATION.md, Math Precision Tiers)
+#if PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_EXACT
+#define BOUND_SQRT  1e-7
+#define BOUND_SIN   1e-7
+#define TIER_NAME   "PAZERVILLE_MATH_EXACT"
+#elif PAZERVILLE_MATH_PRECISION == PAZERVILLE_MATH_REFINED
+#define BOUND_SQRT  5e-6
+#define BOUND_SIN   8e-5
+#define TIER_NAME   "PAZERVILLE_MATH_REFINED"
+#else
+#define BOUND_SQRT  2e-3
+#define BOUND_SIN   2.5e-2
+#define TIER_NAME   "PAZERVILLE_MATH_FAST"
+#endif
+
+// Sweep ranges: distances and squared distances the physics sees, and
+// angles over several turns either side of zero
+#define SQRT_MIN        1e-6
+#define SQRT_MAX        1e6
+#define SQRT_SAMPLES    200000
+#define ANGLE_RANGE     100.0
+#define ANGLE_SAMPLES   200000
+
+typedef struct {
+    const char *name;
+    double bound;
+    double worst;
+    float worst_at;
+} Sweep;
+
+// Note one error against the sweep's worst
+static void record(Sweep *sweep, double error, float at) {
+    if (error > sweep->worst) {
+        sweep->worst = error;
+        sweep->worst_at = at;
+    }
+}
+
+// Print a sweep's result; true if it stayed within its bound
+static bool report(const Sweep &sweep) {
+    bool ok = sweep.worst < sweep.bound;
+    printf("%-10s max error %.3e at %-12g bound %.1e  %s\n",
+           sweep.name, sweep.worst, sweep.worst_at, sweep.bound, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main() {
+    Sweep inv_sqrt = { "pzInvSqrt", BOUND_SQRT, 0.0, 0.0f };
+    Sweep sqrt_ = { "pzSqrt", BOUND_SQRT, 0.0, 0.0f };
+    Sweep sin_ = { "pzSin", BOUND_SIN, 0.0, 0.0f };
+    Sweep cos_ = { "pzCos", BOUND_SIN, 0.0, 0.0f };
+    
+    // Log-spaced, so every binade gets the same number of samples
+    double ratio = pow(SQRT_MAX / SQRT_MIN, 1.0 / (SQRT_SAMPLES - 1));
+    double x = SQRT_MIN;
+    for (int i = 0; i < SQRT_SAMPLES; i++, x *= ratio) {
+        float xf = (float)x;
+        double exact = sqrt((double)xf);
+        record(&inv_sqrt, fabs(pzInvSqrt(xf) * exact - 1.0), xf);
+        record(&sqrt_, fabs(pzSqrt(xf) / exact - 1.0), xf);
+    }
+    
+    for (int i = 0; i < ANGLE_SAMPLES; i++) {
+        float angle = (float)(-ANGLE_RANGE + 2.0 * ANGLE_RANGE * i / (ANGLE_SAMPLES - 1));
+        record(&sin_, fabs(pzSin(angle) - sin((double)angle)), angle);
+        record(&cos_, fabs(pzCos(angle) - cos((double)angle)), angle);
+    }
+    
+    printf("# %s\n", TIER_NAME);
+    bool ok = report(inv_sqrt);
+    ok = report(sqrt_) && ok;
+    ok = report(sin_) && ok;
+    ok = report(cos_) && ok;
+    
+    // The physics takes the length of zero-length springs
+    if (pzSqrt(0.0f) != 0.0f) {
+        printf("pzSqrt(0) = %g, expected 0  FAIL\n", pzSqrt(0.0f));
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+/*
+ * Scroll and Partial Area Test
+ *
+ * Drives the hardware scroll and partial modes of the driver in its default
+ * landscape orientation into ILI9341HostSink, and checks the gate-line
+ * areas programmed, what the glass shows after scrolling, and which
+ * columns updateDisplay() sends around the bands.
+ *
+ * Build (from the repository root):
+ *   g++ -std=gnu++14 -O2 -Itools/host -Iinclude -I. \
+ *       tools/scroll_test.cpp tools/host/host_core.cpp \
+ *       src/ili9341_display.cpp src/ili9341_transport.cpp src/ili9341_font.cpp -o scroll_test
+ *
+ * Usage:
+ *   ./scroll_test        exits non-zero if any check fails
+ */
+
+#include "ili9341_display.h"
+
+#define SCROLL_LEFT     240
+#define SCROLL_WIDTH    80
+#define SCROLL_PUSHES   100     // more than one lap of the band
+#define PARTIAL_FIRST   100
+#define PARTIAL_LAST    199
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+// Colour of the n-th column pushed into the scroll band
+static uint16_t columnColor(int n) {
+    return (uint16_t)(0x1000 + n);
+}
+
+// The scroll area is programmed in gate lines and rolls right to left
+static void testScroll(ILI9341Display &tft, ILI9341HostSink &sink) {
+    // Bands are checked against the 320 gate lines, not the 240 rows
+    tft.setScrollArea(0, ILI9341_GATE_LINES + 1);
+    CHECK(sink.scroll_lines == ILI9341_GATE_LINES, "oversized area was accepted");
+    tft.setScrollArea(0, 300);
+    CHECK(sink.scroll_lines == 300 && sink.scroll_fixed_right == 20,
+          "300-line area: VSCRDEF %u/%u/%u", sink.scroll_fixed_left, sink.scroll_lines, sink.scroll_fixed_right);
+    
+    tft.setScrollArea(SCROLL_LEFT, SCROLL_WIDTH);
+    CHECK(sink.scroll_fixed_left == SCROLL_LEFT && sink.scroll_lines == SCROLL_WIDTH && sink.scroll_fixed_right == 0,
+          "VSCRDEF %u/%u/%u", sink.scroll_fixed_left, sink.scroll_lines, sink.scroll_fixed_right);
+    CHECK(sink.scroll_fixed_left + sink.scroll_lines + sink.scroll_fixed_right == ILI9341_GATE_LINES,
+          "VSCRDEF does not cover all gate lines");
+    
+    uint16_t column[ILI9341_HEIGHT];
+    for (int n = 1; n <= SCROLL_PUSHES; n++) {
+        for (int y = 0; y < ILI9341_HEIGHT; y++) {
+            column[y] = columnColor(n);
+        }
+        sink.resetCounters();
+        tft.scrollLine(column);
+        CHECK(sink.pixels == ILI9341_HEIGHT, "push %d sent %u pixels", n, sink.pixels);
+    }
+    
+    // The newest column is at the right edge, older ones to its left
+    for (int k = 0; k < SCROLL_WIDTH; k++) {
+        uint16_t x = SCROLL_LEFT + SCROLL_WIDTH - 1 - k;
+        for (int y = 0; y < ILI9341_HEIGHT; y += 37) {
+            uint16_t shown = sink.shownAt(x, y);
+            CHECK(shown == columnColor(SCROLL_PUSHES - k), "(%u, %d) shows %04x, expected %04x",
+                  x, y, shown, columnColor(SCROLL_PUSHES - k));
+        }
+    }
+    
+    // A full-screen fill is sent everywhere but the band
+    tft.fillScreen(COLOR_RED);
+    sink.resetCounters();
+    tft.updateDisplay();
+    CHECK(sink.pixels == SCROLL_LEFT * ILI9341_HEIGHT, "flush around the band sent %u pixels", sink.pixels);
+    CHECK(sink.shownAt(SCROLL_LEFT - 1, 120) == COLOR_RED, "column left of the band not flushed");
+    CHECK(sink.shownAt(SCROLL_LEFT, 120) == columnColor(SCROLL_PUSHES - SCROLL_WIDTH + 1),
+          "flush overwrote the scroll band");
+    
+    tft.clearScrollArea();
+    CHECK(sink.scroll_lines == ILI9341_GATE_LINES && sink.scroll_start == 0, "scroll area not cleared");
+}
+
+// The partial area is programmed in gate lines; columns outside it wait
+static void testPartial(ILI9341Display &tft, ILI9341HostSink &sink) {
+    tft.enterPartialMode(0, ILI9341_GATE_LINES - 1);
+    CHECK(sink.partial_last == ILI9341_GATE_LINES - 1, "full partial area clamped to %u", sink.partial_last);
+    
+    tft.enterPartialMode(PARTIAL_FIRST, PARTIAL_LAST);
+    CHECK(sink.partial_first == PARTIAL_FIRST && sink.partial_last == PARTIAL_LAST,
+          "PTLAR %u - %u", sink.partial_first, sink.partial_last);
+    
+    tft.fillScreen(COLOR_BLUE);
+    sink.resetCounters();
+    tft.updateDisplay();
+    uint32_t driven = (PARTIAL_LAST - PARTIAL_FIRST + 1) * ILI9341_HEIGHT;
+    CHECK(sink.pixels == driven, "partial flush sent %u pixels, expected %u", sink.pixels, driven);
+    CHECK(sink.shownAt(PARTIAL_FIRST, 0) == COLOR_BLUE, "first driven column not flushed");
+    CHECK(sink.shownAt(PARTIAL_FIRST - 1, 0) != COLOR_BLUE, "column before the area was flushed");
+    CHECK(sink.shownAt(PARTIAL_LAST + 1, 239) != COLOR_BLUE, "column after the area was flushed");
+    
+    // The rest goes out once the whole panel is driven again
+    tft.exitPartialMode();
+    sink.resetCounters();
+    tft.updateDisplay();
+    CHECK(sink.shownAt(0, 0) == COLOR_BLUE && sink.shownAt(ILI9341_WIDTH - 1, 239) == COLOR_BLUE,
+          "columns outside the area not sent after exitPartialMode()");
+}
+
+int main() {
+    ILI9341Display tft;
+    if (!tft.initialize()) {
+        printf("FAIL: initialize\n");
+        return 1;
+    }
+    ILI9341HostSink &sink = tft.getTransport();
+    
+    testScroll(tft, sink);
+    testPartial(tft, sink);
+    
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("scroll_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * Touch Drag Replay
+ *
+ * Plays a scripted pen through PazervilleTouch in place of the XPT2046 and
+ * feeds the filtered points to PazervilleDisplay::handleTouch(), running
+ * touch sampling and frames on the same schedule as the Teensy. Prints the
+ * held node's position every frame and a latency summary at the end.
+ *
+ * Time is virtual. Rasterization costs none of it, but each flushed pixel
+ * advances the clock by its time on the SPI bus, and touch ticks that come
+ * due during a flush run from the sink's pixel hook, as the timer interrupt
+ * would. Those ticks must all be deferred and then served when the flush
+ * hands the bus over between rows, the scripted controller must never be
+ * read while the panel holds the bus, and the panel must end up showing
+ * the framebuffer; otherwise the replay exits non-zero.
+ *
+ * Build (from the repository root):
+ *   g++ -std=gnu++14 -O2 -Itools/host -Iinclude -I. \
+ *       tools/touch_replay.cpp tools/host/host_core.cpp \
+ *       src/pazerville_touch.cpp src/pazerville_display.cpp src/pazerville_hud.cpp \
+ *       src/pazerville_sprites.cpp src/pazerville_math.cpp src/ili9341_display.cpp \
+ *       src/pazerville_commands.cpp src/ili9341_transport.cpp src/ili9341_font.cpp -o touch_replay
+ *
+ * Usage:
+ *   ./touch_replay script.txt    exits non-zero if touch and the panel collide
+ *
+ * Script, one event per line; '#' starts a comment:
+ *   <ms> down <x> <y>     pen lands at a screen position
+ *   <ms> move <x> <y>     pen slides in a straight line to here by <ms>
+ *   <ms> up               pen lifts
+ *
+ * The graph is a star of six nodes around the centre node at (160, 120).
+ */
+
+#include "ili9341_display.h"
+#include "pazerville_display.h"
+#include "pazerville_examples.h"
+#include "pazerville_touch.h"
+
+#include <vector>
+
+// Schedule, microseconds
+#define REPLAY_FRAME_US     16667
+#define REPLAY_TICK_US      250
+#define REPLAY_TAIL_US      500000  // run on after the last event
+#define REPLAY_PRESSURE     600
+#define REPLAY_NOISE        4       // raw counts either way
+
+// Bus time of a flush: the sink calls back every REPLAY_HOOK_PIXELS pixels,
+// which take REPLAY_HOOK_US at 16 bits per pixel and 32 MHz
+#define REPLAY_HOOK_PIXELS  64
+#define REPLAY_HOOK_US      32
+
+typedef struct {
+    uint32_t time_us;
+    bool down;
+    float x;
+    float y;
+} ReplayEvent;
+
+// Touch sampling schedule, shared by the main loop and the flush hook
+typedef struct {
+    PazervilleTouch *touch;
+    uint32_t next_sample;
+    uint32_t sample_period;
+    uint32_t flush_ticks;      // ticks that came due inside a flush
+} ReplaySampler;
+
+static std::vector<ReplayEvent> events;
+static const ILI9341HostSink *panel_bus = nullptr;
+static uint32_t bus_collisions = 0;
+
+// Pen position and contact at a point in time
+static bool penAt(uint32_t time_us, float *x, float *y) {
+    const ReplayEvent *prev = nullptr;
+    for (size_t i = 0; i < events.size(); i++) {
+        const ReplayEvent &e = events[i];
+        if (e.time_us > time_us) {
+            // Slide toward the next move from the last position
+            if (prev && prev->down && e.down) {
+                float t = (float)(time_us - prev->time_us) / (float)(e.time_us - prev->time_us);
+                *x = prev->x + (e.x - prev->x) * t;
+                *y = prev->y + (e.y - prev->y) * t;
+                return true;
+            }
+            break;
+        }
+        prev = &e;
+    }
+    if (!prev || !prev->down) return false;
+    
+    *x = prev->x;
+    *y = prev->y;
+    return true;
+}
+
+// Raw conversions for the pen, using the default calibration in reverse
+static uint16_t scriptedTouch(uint8_t command, uint32_t time_us) {
+    // On the Teensy this conversion would corrupt the transfer in progress
+    if (panel_bus && panel_bus->in_transaction) {
+        bus_collisions++;
+    }
+    
+    float x = 0.0f, y = 0.0f;
+    bool down = penAt(time_us, &x, &y);
+    int noise = rand() % (2 * REPLAY_NOISE + 1) - REPLAY_NOISE;
+    
+    switch (command) {
+        case XPT2046_CMD_Z1:
+            return down ? REPLAY_PRESSURE : 0;
+        case XPT2046_CMD_Z2:
+            return PAZERVILLE_TOUCH_FULL_SCALE;
+        case XPT2046_CMD_X:
+            return PAZERVILLE_TOUCH_RAW_X_MIN + noise
+                + (int)(x * (PAZERVILLE_TOUCH_RAW_X_MAX - PAZERVILLE_TOUCH_RAW_X_MIN) / PAZERVILLE_WIDTH);
+        case XPT2046_CMD_Y:
+            return PAZERVILLE_TOUCH_RAW_Y_MIN + noise
+                + (int)(y * (PAZERVILLE_TOUCH_RAW_Y_MAX - PAZERVILLE_TOUCH_RAW_Y_MIN) / PAZERVILLE_HEIGHT);
+        default:
+            return 0;
+    }
+}
+
+// Flush in progress: let the bus time pass, and run the touch ticks that
+// come due meanwhile, as the timer interrupt would
+static void flushHook(void *context) {
+    ReplaySampler *sampler = (ReplaySampler *)context;
+    delayMicroseconds(REPLAY_HOOK_US);
+    while (micros() >= sampler->next_sample) {
+        sampler->touch->sampleTick();
+        sampler->next_sample += sampler->sample_period;
+        sampler->flush_ticks++;
+    }
+}
+
+// Panel pixels that differ from the framebuffer seen through the palette
+static uint32_t panelMismatches(ILI9341Display &tft) {
+    ILI9341HostSink &sink = tft.getTransport();
+    const uint8_t *index = tft.getIndexBuffer();
+    uint32_t bad = 0;
+    for (uint16_t y = 0; y < ILI9341_HEIGHT; y++) {
+        for (uint16_t x = 0; x < ILI9341_WIDTH; x++) {
+            if (sink.pixelAt(x, y) != tft.getPaletteEntry(index[y * ILI9341_WIDTH + x])) bad++;
+        }
+    }
+    return bad;
+}
+
+// Parse the event script; false on a malformed line
+static bool loadScript(FILE *f) {
+    char line[128];
+    int number = 0;
+    while (fgets(line, sizeof(line), f)) {
+        number++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        
+        unsigned ms;
+        char verb[8];
+        ReplayEvent e;
+        e.x = e.y = 0.0f;
+        int fields = sscanf(line, "%u %7s %f %f", &ms, verb, &e.x, &e.y);
+        if (fields <= 0) continue;
+        
+        e.time_us = ms * 1000;
+        if (fields == 4 && (strcmp(verb, "down") == 0 || strcmp(verb, "move") == 0)) {
+            e.down = true;
+        } else if (fields >= 2 && strcmp(verb, "up") == 0) {
+            e.down = false;
+        } else {
+            fprintf(stderr, "line %d: expected '<ms> down|move <x> <y>' or '<ms> up'\n", number);
+            return false;
+        }
+        if (!events.empty() && e.time_us < events.back().time_us) {
+            fprintf(stderr, "line %d: events must be in time order\n", number);
+            return false;
+        }
+        events.push_back(e);
+    }
+    return !events.empty();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s script.txt\n", argv[0]);
+        return 1;
+    }
+    
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    bool ok = loadScript(f);
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "no events in %s\n", argv[1]);
+        return 1;
+    }
+    
+    ILI9341Display tft;
+    tft.initialize(ILI9341_COLOR_INDEXED8);
+    PazervilleDisplay pazerville(&tft);
+    pazerville.initialize();
+    pazerville.setTimeStep(0.016f);
+    PazervilleExamples::createStarNetwork(&pazerville, 6);
+    
+    PazervilleTouch touch;
+    touch.setSource(scriptedTouch);
+    
+    // Script times count from the end of the display bring-up
+    uint32_t start_us = micros();
+    for (size_t i = 0; i < events.size(); i++) {
+        events[i].time_us += start_us;
+    }
+    
+    ReplaySampler sampler;
+    sampler.touch = &touch;
+    sampler.next_sample = start_us;
+    sampler.sample_period = 1000000 / touch.getSampleRate();
+    sampler.flush_ticks = 0;
+    
+    ILI9341HostSink &sink = tft.getTransport();
+    panel_bus = &sink;
+    sink.pixel_hook = flushHook;
+    sink.hook_context = &sampler;
+    sink.hook_pixels = REPLAY_HOOK_PIXELS;
+    
+    printf("# frame %u us, touch sample %u us\n", REPLAY_FRAME_US, sampler.sample_period);
+    printf("#   ms  node      x      y  latency_us\n");
+    
+    // Latency from each press in the script to the frame showing the pickup
+    size_t next_press = 0;
+    uint32_t press_us = 0;
+    bool awaiting_pickup = false;
+    float pickup_sum = 0.0f, pickup_max = 0.0f;
+    int pickups = 0;
+    float latency_sum = 0.0f, latency_max = 0.0f;
+    int moves = 0;
+    
+    uint32_t end_us = events.back().time_us + REPLAY_TAIL_US;
+    uint32_t next_frame = start_us;
+    PazervilleTouchPoint point;
+    while (micros() < end_us) {
+        uint32_t now = micros();
+        
+        // Note presses as the script reaches them
+        while (next_press < events.size() && events[next_press].time_us <= now) {
+            bool was_down = next_press > 0 && events[next_press - 1].down;
+            if (events[next_press].down && !was_down) {
+                press_us = events[next_press].time_us;
+                awaiting_pickup = true;
+            }
+            next_press++;
+        }
+        
+        if (now >= sampler.next_sample) {
+            touch.sampleTick();
+            sampler.next_sample += sampler.sample_period;
+        }
+        
+        if (now >= next_frame) {
+            bool moved = false;
+            if (touch.read(&point)) {
+                moved = pazerville.handleTouch(point);
+            }
+            pazerville.simulate();
+            pazerville.draw();
+            next_frame += REPLAY_FRAME_US;
+            
+            int held = pazerville.getDragNode();
+            if (held >= 0 && awaiting_pickup) {
+                float wait = (float)(micros() - press_us);
+                pickup_sum += wait;
+                if (wait > pickup_max) pickup_max = wait;
+                pickups++;
+                awaiting_pickup = false;
+            }
+            if (moved) {
+                float latency = pazerville.getLastTouchLatency();
+                latency_sum += latency;
+                if (latency > latency_max) latency_max = latency;
+                moves++;
+                
+                const PazervilleNode *node = pazerville.getNode(held);
+                printf("%6u  %4d  %5.1f  %5.1f  %10.0f\n", (now - start_us) / 1000, held, node->x, node->y, latency);
+            }
+        }
+        
+        delayMicroseconds(REPLAY_TICK_US);
+    }
+    
+    printf("# pickups %d, press to pickup mean %.0f us max %.0f us\n",
+           pickups, pickups ? pickup_sum / pickups : 0.0f, pickup_max);
+    printf("# drag moves %d, sample to screen mean %.0f us max %.0f us\n",
+           moves, moves ? latency_sum / moves : 0.0f, latency_max);
+    printf("# touch ticks during flushes %u, deferred for the bus %u\n",
+           sampler.flush_ticks, touch.getDeferredTicks());
+    
+    ok = true;
+    if (touch.getDeferredTicks() != sampler.flush_ticks) {
+        printf("FAIL: %u tick(s) inside a flush were not deferred\n", sampler.flush_ticks - touch.getDeferredTicks());
+        ok = false;
+    }
+    if (bus_collisions) {
+        printf("FAIL: the controller was read %u time(s) while the panel held the bus\n", bus_collisions);
+        ok = false;
+    }
+    uint32_t bad = panelMismatches(tft);
+    if (bad) {
+        printf("FAIL: %u panel pixel(s) differ from the framebuffer\n", bad);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}